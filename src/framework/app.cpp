@@ -1,7 +1,10 @@
 #include "app.hpp"
 #include "renderer.hpp"
+#include "capture.hpp"
+#include "stats.hpp"
 
 #include <SDL3/SDL.h>
+#include <float.h>
 
 #ifdef __EMSCRIPTEN__
 #include <emscripten.h>
@@ -17,33 +20,103 @@ namespace
     bool app_is_exiting = false;
     SDL_Window* app_window = nullptr;
     Renderer* app_renderer_api = nullptr;
+
+    bool app_init(int width, int height, SDL_WindowFlags flags, RendererType type)
+    {
+        // Initialize SDL
+        if (!SDL_Init(SDL_INIT_VIDEO | SDL_INIT_EVENTS)) {
+            SDL_Log("SDL_Init failed: %s", SDL_GetError());
+            return false;
+        }
+
+        // Create SDL window
+        app_window = SDL_CreateWindow("game", width, height, flags);
+        if (!app_window) {
+            SDL_Log("SDL_CreateWindow failed: %s", SDL_GetError());
+            SDL_Quit();
+            return false;
+        }
+
+        app_renderer_api = Renderer::try_make_renderer(type);
+        if (!app_renderer_api || !app_renderer_api->init()) {
+            SDL_Log("Failed to create renderer");
+            delete app_renderer_api;
+            app_renderer_api = nullptr;
+            return false;
+        }
+
+        return true;
+    }
 }
 
 bool App::run()
 {
-    // Initialize SDL
-    if (!SDL_Init(SDL_INIT_VIDEO | SDL_INIT_EVENTS)) {
-        SDL_Log("SDL_Init failed: %s", SDL_GetError());
-        return -1;
+    if (!app_init(1280, 720, 0, RendererType::D3D11))
+        return false;
+
+    app_is_running = true;
+
+    // Begin main loop
+    while (!app_is_exiting)
+    {
+        Internal::app_step();
     }
 
-    // Create SDL window
-    app_window = SDL_CreateWindow("game", 1280, 720, 0);
-    if (!app_window) {
-        SDL_Log("SDL_CreateWindow failed: %s", SDL_GetError());
-        SDL_Quit();
-        return -1;
+    return true;
+}
+
+bool App::replay(const char* path, uint32 iterations, RendererType type)
+{
+    Capture::Stream stream;
+    if (!Capture::load(path, stream) || stream.frames.empty())
+        return false;
+
+    // Draw payloads are uploaded as-is, so the layout has to match this build
+    if (stream.vertexStride != sizeof(Vertex))
+    {
+        SDL_Log("Replay: %s has vertex stride %u, expected %u", path, stream.vertexStride, (uint32)sizeof(Vertex));
+        return false;
     }
 
-    app_renderer_api = Renderer::try_make_renderer(RendererType::D3D11);
-    app_renderer_api->init();
+    auto size = stream.frames[0].size;
+    if (!app_init(size.x, size.y, SDL_WINDOW_HIDDEN, type))
+        return false;
 
     app_is_running = true;
 
-    // Begin main loop
-    while (!app_is_exiting)
+    const double frequency = (double)SDL_GetPerformanceFrequency();
+    for (size_t i = 0; i < stream.frames.size(); i++)
     {
-        Internal::app_step();
+        double total = 0.0, best = DBL_MAX, worst = 0.0;
+
+        for (uint32 n = 0; n < iterations; n++)
+        {
+            uint64 start = SDL_GetPerformanceCounter();
+
+            app_renderer_api->before_render();
+            app_renderer_api->replay(stream.frames[i]);
+            app_renderer_api->after_render();
+
+            double ms = (double)(SDL_GetPerformanceCounter() - start) * 1000.0 / frequency;
+            total += ms;
+            best = SDL_min(best, ms);
+            worst = SDL_max(worst, ms);
+        }
+
+        SDL_Log("Frame %zu: avg %.3f ms, min %.3f ms, max %.3f ms (%u runs)",
+            i, total / iterations, best, worst, iterations);
+    }
+
+    // Resource footprint of the replayed frames
+    auto stats = Stats::snapshot();
+    for (int i = 0; i < (int)Stats::Category::Count; i++)
+    {
+        auto& category = stats.categories[i];
+        SDL_Log("%s: %llu bytes (peak %llu), %u allocations",
+            Stats::category_name((Stats::Category)i),
+            (unsigned long long)category.bytes,
+            (unsigned long long)category.highWater,
+            category.allocations);
     }
 
     return true;
@@ -58,8 +131,12 @@ void App::exit()
 {
     app_is_running = false;
 
-    app_renderer_api->shutdown();
-    delete app_renderer_api;
+    if (app_renderer_api)
+    {
+        app_renderer_api->shutdown();
+        delete app_renderer_api;
+        app_renderer_api = nullptr;
+    }
 
     SDL_DestroyWindow(app_window);
     SDL_Quit();
@@ -89,6 +166,21 @@ void Internal::app_step()
         {
             app_is_exiting = true;
         } break;
+        case SDL_EVENT_KEY_DOWN:
+        {
+            // Capture the next frame for offline replay
+            if (event.key.key == SDLK_F12)
+                Capture::begin("capture.d3dcap", 1);
+
+            // Toggle dynamic resolution scaling
+            if (event.key.key == SDLK_F11 && app_renderer_api)
+            {
+                static DynamicResolutionSettings resolution;
+                resolution.enabled = !resolution.enabled;
+                app_renderer_api->set_dynamic_resolution(resolution);
+                SDL_Log("Dynamic resolution %s", resolution.enabled ? "on" : "off");
+            }
+        } break;
         case SDL_EVENT_MOUSE_BUTTON_DOWN:
         {
             auto button = event.button.button - 1;
@@ -107,10 +199,11 @@ void Internal::app_step()
             const auto yOffset = static_cast<float>(event.wheel.y);
         } break;
         }
-
-        app_renderer_api->before_render();
-        app_renderer_api->clear_backbuffer({ 0.392f, 0.584f, 0.929f, 1.0f }, 0, 0, ClearMask::Color);
-        app_renderer_api->render({});
-        app_renderer_api->after_render();
     }
+
+    // Render every step, not only when an event arrived, so frame times are real
+    app_renderer_api->before_render();
+    app_renderer_api->clear_backbuffer({ 0.392f, 0.584f, 0.929f, 1.0f }, 0, 0, ClearMask::Color);
+    app_renderer_api->render({});
+    app_renderer_api->after_render();
 }
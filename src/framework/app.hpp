@@ -1,12 +1,16 @@
 #pragma once
 
 #include "common.hpp"
+#include "graphics.hpp"
 
 namespace Framework
 {
 	namespace App
 	{
 		bool run();
+
+		// Headless replay of a capture file, logging timings per frame
+		bool replay(const char* path, uint32 iterations, RendererType type);
 		
 		bool is_running();
 
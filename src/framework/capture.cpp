@@ -0,0 +1,271 @@
+#include "capture.hpp"
+#include "stats.hpp"
+
+#include <SDL3/SDL.h>
+
+#include <stdio.h>
+#include <string.h>
+#include <string>
+
+using namespace Framework;
+
+namespace
+{
+	constexpr uint32 capture_magic = 0x50434744; // "DGCP"
+	constexpr uint32 capture_version = 2;	// 2: vertex mask weights are 0..1
+
+	struct FileHeader
+	{
+		uint32 magic;
+		uint32 version;
+		uint32 vertexStride;
+		uint32 frameCount;
+	};
+
+	struct FrameHeader
+	{
+		int32 width;
+		int32 height;
+		uint32 byteSize;
+	};
+
+	// Recording state
+	std::string capture_path;
+	uint32 capture_frames_left = 0;
+	bool capture_pending = false;
+	bool capture_active = false;
+	Capture::Stream capture_stream;
+	uint64 capture_stream_bytes = 0;
+
+	// The payload is the header followed by the body, either may be empty
+	void write_command(Capture::Command command, const void* header, uint32 headerSize, const void* body = nullptr, uint32 bodySize = 0)
+	{
+		auto& data = capture_stream.frames.back().data;
+		auto offset = data.size();
+		uint32 size = headerSize + bodySize;
+		data.resize(offset + 1 + sizeof(uint32) + size);
+
+		data[offset] = (uint8)command;
+		memcpy(&data[offset + 1], &size, sizeof(uint32));
+		if (headerSize > 0)
+			memcpy(&data[offset + 1 + sizeof(uint32)], header, headerSize);
+		if (bodySize > 0)
+			memcpy(&data[offset + 1 + sizeof(uint32) + headerSize], body, bodySize);
+	}
+
+	bool write_file()
+	{
+		FILE* file = fopen(capture_path.c_str(), "wb");
+		if (!file)
+		{
+			SDL_Log("Capture: failed to open %s for writing", capture_path.c_str());
+			return false;
+		}
+
+		FileHeader header = { capture_magic, capture_version, capture_stream.vertexStride, (uint32)capture_stream.frames.size() };
+		fwrite(&header, sizeof(header), 1, file);
+
+		for (auto& frame : capture_stream.frames)
+		{
+			FrameHeader frameHeader = { frame.size.x, frame.size.y, (uint32)frame.data.size() };
+			fwrite(&frameHeader, sizeof(frameHeader), 1, file);
+			fwrite(frame.data.data(), 1, frame.data.size(), file);
+		}
+
+		fclose(file);
+		SDL_Log("Capture: wrote %u frame(s) to %s", header.frameCount, capture_path.c_str());
+		return true;
+	}
+}
+
+Capture::Reader::Reader(const Frame& frame)
+	: cursor(frame.data.data()), end(frame.data.data() + frame.data.size())
+{
+
+}
+
+bool Capture::Reader::next(Command& command, const uint8*& payload, uint32& size)
+{
+	if (end - cursor < (ptrdiff_t)(1 + sizeof(uint32)))
+		return false;
+
+	command = (Command)cursor[0];
+	memcpy(&size, cursor + 1, sizeof(uint32));
+	payload = cursor + 1 + sizeof(uint32);
+
+	if ((size_t)(end - payload) < size)
+		return false;
+
+	cursor = payload + size;
+	return true;
+}
+
+bool Capture::begin(const char* path, uint32 frameCount)
+{
+	if (capture_active || capture_pending || frameCount == 0)
+		return false;
+
+	capture_path = path;
+	capture_frames_left = frameCount;
+	capture_stream = {};
+	capture_stream.vertexStride = sizeof(Vertex);
+	capture_pending = true;
+
+	return true;
+}
+
+bool Capture::is_recording()
+{
+	return capture_active;
+}
+
+bool Capture::load(const char* path, Stream& stream)
+{
+	FILE* file = fopen(path, "rb");
+	if (!file)
+	{
+		SDL_Log("Capture: failed to open %s", path);
+		return false;
+	}
+
+	fseek(file, 0, SEEK_END);
+	long fileSize = ftell(file);
+	fseek(file, 0, SEEK_SET);
+
+	FileHeader header;
+	if (fileSize < 0 || fread(&header, sizeof(header), 1, file) != 1 || header.magic != capture_magic || header.version != capture_version)
+	{
+		SDL_Log("Capture: %s is not a valid capture file", path);
+		fclose(file);
+		return false;
+	}
+
+	// Every count read from the file is bounded by the bytes left, so a corrupt
+	// header fails here instead of in an allocation
+	uint64 remaining = (uint64)fileSize - sizeof(header);
+	if ((uint64)header.frameCount * sizeof(FrameHeader) > remaining)
+	{
+		SDL_Log("Capture: %s is truncated", path);
+		fclose(file);
+		return false;
+	}
+
+	stream.vertexStride = header.vertexStride;
+	stream.frames.resize(header.frameCount);
+
+	for (auto& frame : stream.frames)
+	{
+		FrameHeader frameHeader;
+		if (fread(&frameHeader, sizeof(frameHeader), 1, file) != 1)
+		{
+			fclose(file);
+			return false;
+		}
+		remaining -= sizeof(frameHeader);
+
+		if (frameHeader.byteSize > remaining || frameHeader.width <= 0 || frameHeader.height <= 0)
+		{
+			SDL_Log("Capture: %s is truncated", path);
+			fclose(file);
+			return false;
+		}
+		remaining -= frameHeader.byteSize;
+
+		frame.size = { frameHeader.width, frameHeader.height };
+		frame.data.resize(frameHeader.byteSize);
+		if (fread(frame.data.data(), 1, frame.data.size(), file) != frame.data.size())
+		{
+			SDL_Log("Capture: %s is truncated", path);
+			fclose(file);
+			return false;
+		}
+	}
+
+	fclose(file);
+	return true;
+}
+
+void Internal::capture_frame_begin(const glm::ivec2& size)
+{
+	if (capture_pending)
+	{
+		capture_pending = false;
+		capture_active = true;
+	}
+
+	if (!capture_active)
+		return;
+
+	capture_stream.frames.emplace_back();
+	capture_stream.frames.back().size = size;
+}
+
+void Internal::capture_frame_end()
+{
+	if (!capture_active)
+		return;
+
+	capture_stream_bytes += capture_stream.frames.back().data.capacity();
+	Internal::stats_alloc(Stats::Category::Capture, capture_stream.frames.back().data.capacity());
+
+	if (--capture_frames_left == 0)
+	{
+		capture_active = false;
+		write_file();
+		capture_stream = {};
+
+		Internal::stats_release(Stats::Category::Capture, capture_stream_bytes);
+		capture_stream_bytes = 0;
+	}
+}
+
+void Internal::capture_clear(const glm::vec4& color, float depth, uint8 stencil, ClearMask mask)
+{
+	if (!capture_active)
+		return;
+
+	Capture::ClearData data = { color, depth, stencil, (uint32)mask };
+	write_command(Capture::Command::Clear, &data, sizeof(data));
+}
+
+void Internal::capture_matrix(const void* matrix, uint32 size)
+{
+	if (!capture_active)
+		return;
+
+	write_command(Capture::Command::Matrix, matrix, size);
+}
+
+void Internal::capture_scissor(const void* rect, uint32 size)
+{
+	if (!capture_active)
+		return;
+
+	write_command(Capture::Command::Scissor, rect, size);
+}
+
+void Internal::capture_draw(const void* vertices, uint32 stride, uint32 count)
+{
+	if (!capture_active)
+		return;
+
+	capture_stream.vertexStride = stride;
+	write_command(Capture::Command::Draw, vertices, stride * count);
+}
+
+void Internal::capture_texture(const Capture::TextureData& texture)
+{
+	if (!capture_active)
+		return;
+
+	write_command(Capture::Command::Texture, &texture, sizeof(texture));
+}
+
+void Internal::capture_mesh(const Capture::MeshData& mesh, const void* vertices, uint32 stride, uint32 count)
+{
+	if (!capture_active)
+		return;
+
+	capture_stream.vertexStride = stride;
+	write_command(Capture::Command::Mesh, &mesh, sizeof(mesh), vertices, stride * count);
+}
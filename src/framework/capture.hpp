@@ -0,0 +1,95 @@
+#pragma once
+
+#include "common.hpp"
+#include "graphics.hpp"
+
+#include <vector>
+
+namespace Framework
+{
+	// Records the stream of renderer and batcher calls into a compact binary file
+	// so a frame from the field can be replayed offline as a benchmark.
+	namespace Capture
+	{
+		enum class Command : uint8
+		{
+			Clear,
+			Matrix,
+			Draw,
+			Scissor,
+			Texture,
+			Mesh,
+		};
+
+		struct ClearData
+		{
+			glm::vec4 color;
+			float depth;
+			uint32 stencil;
+			uint32 mask;
+		};
+
+		// Texture bound for the draws that follow, id 0 is none. Only the
+		// description is recorded, replay binds a stand-in with the same layout.
+		struct TextureData
+		{
+			uint32 id;
+			int32 width;
+			int32 height;
+			uint32 format;
+			uint32 mipCount;
+		};
+
+		// Header of a retained mesh draw, followed by its vertices. id and revision
+		// identify the contents, so replay uploads each version only once.
+		struct MeshData
+		{
+			uint32 id;
+			uint32 revision;
+		};
+
+		struct Frame
+		{
+			glm::ivec2 size;
+			std::vector<uint8> data;
+		};
+
+		struct Stream
+		{
+			uint32 vertexStride = 0;
+			std::vector<Frame> frames;
+		};
+
+		// Walks the packed commands of a single frame
+		class Reader
+		{
+		public:
+			Reader(const Frame& frame);
+
+			bool next(Command& command, const uint8*& payload, uint32& size);
+
+		private:
+			const uint8* cursor;
+			const uint8* end;
+		};
+
+		// Starts recording at the next frame and writes the file after frameCount frames
+		bool begin(const char* path, uint32 frameCount);
+
+		bool is_recording();
+
+		bool load(const char* path, Stream& stream);
+	}
+
+	namespace Internal
+	{
+		void capture_frame_begin(const glm::ivec2& size);
+		void capture_frame_end();
+		void capture_clear(const glm::vec4& color, float depth, uint8 stencil, ClearMask mask);
+		void capture_matrix(const void* matrix, uint32 size);
+		void capture_scissor(const void* rect, uint32 size);
+		void capture_draw(const void* vertices, uint32 stride, uint32 count);
+		void capture_texture(const Capture::TextureData& texture);
+		void capture_mesh(const Capture::MeshData& mesh, const void* vertices, uint32 stride, uint32 count);
+	}
+}
@@ -0,0 +1,73 @@
+#include "dynamic_resolution.hpp"
+
+#include <algorithm>
+#include <cmath>
+
+using namespace Framework;
+
+namespace
+{
+	// Leave some slack under the target so spikes don't immediately miss it
+	constexpr float headroom = 0.9f;
+
+	// Only grow back when comfortably under budget, avoids oscillating
+	constexpr float grow_threshold = 0.8f;
+
+	// Scales are snapped so small timing noise doesn't resize every window
+	constexpr float scale_step = 1.0f / 32.0f;
+}
+
+DynamicResolution::DynamicResolution(const DynamicResolutionSettings& settings)
+{
+	set_settings(settings);
+}
+
+void DynamicResolution::set_settings(const DynamicResolutionSettings& value)
+{
+	settings = value;
+	settings.window = std::max(settings.window, 1u);
+	settings.minScale = std::min(std::max(settings.minScale, scale_step), 1.0f);
+	settings.maxScale = std::min(std::max(settings.maxScale, settings.minScale), 1.0f);
+
+	current = std::min(std::max(current, settings.minScale), settings.maxScale);
+	reset();
+}
+
+void DynamicResolution::reset()
+{
+	history.assign(settings.window, 0.0f);
+	next = 0;
+	filled = 0;
+}
+
+void DynamicResolution::add_frame_time(float ms)
+{
+	history[next] = ms;
+	next = (next + 1) % settings.window;
+	filled++;
+
+	// Wait for a full window of frames rendered at the current scale
+	if (filled < settings.window)
+		return;
+
+	float average = 0.0f;
+	for (float time : history)
+		average += time;
+	average /= settings.window;
+
+	float budget = settings.targetFrameMs * headroom;
+	if (average <= 0.0f || (average <= budget && average >= budget * grow_threshold))
+		return;
+
+	// Predicted scale to hit the budget, approached halfway to damp the loop
+	float ideal = current * sqrtf(budget / average);
+	float target = current + (ideal - current) * 0.5f;
+	target = roundf(target / scale_step) * scale_step;
+	target = std::min(std::max(target, settings.minScale), settings.maxScale);
+
+	if (target != current)
+	{
+		current = target;
+		filled = 0;
+	}
+}
@@ -0,0 +1,44 @@
+#pragma once
+
+#include "common.hpp"
+
+#include <vector>
+
+namespace Framework
+{
+	struct DynamicResolutionSettings
+	{
+		bool enabled = false;
+		float targetFrameMs = 1000.0f / 60.0f;
+		float minScale = 0.5f;
+		float maxScale = 1.0f;
+		uint32 window = 16;			// frames averaged before each adjustment
+		bool nativeUI = true;		// draw UI after the upscale, at window resolution
+	};
+
+	// Picks the render scale from the average of the last N frame times. The cost
+	// of a fill-rate bound frame scales with pixel count, i.e. with scale squared.
+	class DynamicResolution
+	{
+	public:
+		DynamicResolution(const DynamicResolutionSettings& settings = {});
+
+		void set_settings(const DynamicResolutionSettings& settings);
+
+		const DynamicResolutionSettings& get_settings() const { return settings; }
+
+		void add_frame_time(float ms);
+
+		// Drops the history, e.g. after a resize
+		void reset();
+
+		float scale() const { return current; }
+
+	private:
+		DynamicResolutionSettings settings;
+		std::vector<float> history;
+		uint32 next = 0;
+		uint32 filled = 0;
+		float current = 1.0f;
+	};
+}
@@ -1,5 +1,8 @@
 #pragma once
 
+#include <stdint.h>
+#include <glm/glm.hpp>
+
 enum class RendererType
 {
 	None = -1,
@@ -70,6 +73,19 @@ enum class BlendMask
 	RGBA = Red | Green | Blue | Alpha,
 };
 
+enum class TextureFormat
+{
+	RGBA8,
+	BC1,
+	BC3,
+};
+
+enum class MipFilter
+{
+	Box,
+	Kaiser,
+};
+
 enum class ClearMask
 {
 	None = 0,
@@ -79,6 +95,22 @@ enum class ClearMask
 	All = (int)Color | (int)Depth | (int)Stencil
 };
 
+// Vertex layout of the sprite batcher
+struct Vertex
+{
+	glm::vec2 position;
+	glm::vec2 texCoord;
+	glm::vec4 color;
+	glm::vec4 mask;
+};
+
+// Vertex::mask weights for texture color, texture alpha and vertex color
+namespace VertexMask
+{
+	inline const glm::vec4 Textured = { 1, 0, 0, 0 };
+	inline const glm::vec4 Solid = { 0, 0, 1, 0 };
+}
+
 class Shader
 {
 protected:
@@ -107,6 +139,9 @@ public:
 	Texture& operator=(Texture&&) = delete;
 
 	virtual ~Texture() = default;
+
+	// Size of the top mip level in texels
+	virtual glm::ivec2 get_size() const = 0;
 };
 
 class RenderTarget
@@ -135,6 +170,13 @@ public:
 	Mesh(Mesh&&) = delete;
 	Mesh& operator=(const Mesh&) = delete;
 	Mesh& operator=(Mesh&&) = delete;
+
+	virtual ~Mesh() = default;
+
+	// Replaces the retained geometry
+	virtual void set_vertices(const Vertex* vertices, uint32_t count) = 0;
+
+	virtual uint32_t vertex_count() const = 0;
 };
 
 struct DrawCall
@@ -0,0 +1,137 @@
+#include "jobs.hpp"
+
+#include <atomic>
+#include <condition_variable>
+#include <mutex>
+#include <thread>
+#include <vector>
+
+using namespace Framework;
+
+namespace
+{
+	struct Batch
+	{
+		const std::function<void(int)>* fn = nullptr;
+		int count = 0;
+		std::atomic<int> next{ 0 };
+		std::atomic<int> done{ 0 };
+		int users = 0;
+	};
+
+	struct Pool
+	{
+		std::mutex mutex;
+		std::mutex submitMutex;
+		std::condition_variable wake;
+		std::condition_variable finished;
+		std::vector<std::thread> workers;
+		Batch* batch = nullptr;
+		uint64 generation = 0;
+		bool quit = false;
+
+		~Pool()
+		{
+			{
+				std::lock_guard<std::mutex> lock(mutex);
+				quit = true;
+			}
+			wake.notify_all();
+
+			for (auto& worker : workers)
+				worker.join();
+		}
+	};
+
+	Pool jobs_pool;
+	std::once_flag jobs_started;
+	thread_local bool jobs_in_job = false;
+
+	void run_batch(Batch& batch)
+	{
+		jobs_in_job = true;
+		for (int i = batch.next++; i < batch.count; i = batch.next++)
+		{
+			(*batch.fn)(i);
+			batch.done++;
+		}
+		jobs_in_job = false;
+	}
+
+	void worker_main()
+	{
+		uint64 seen = 0;
+		while (true)
+		{
+			Batch* batch;
+			{
+				std::unique_lock<std::mutex> lock(jobs_pool.mutex);
+				jobs_pool.wake.wait(lock, [&]() { return jobs_pool.quit || jobs_pool.generation != seen; });
+				if (jobs_pool.quit)
+					return;
+
+				seen = jobs_pool.generation;
+				batch = jobs_pool.batch;
+				if (!batch)
+					continue;
+				batch->users++;
+			}
+
+			run_batch(*batch);
+
+			{
+				std::lock_guard<std::mutex> lock(jobs_pool.mutex);
+				batch->users--;
+			}
+			jobs_pool.finished.notify_all();
+		}
+	}
+
+	void start_workers()
+	{
+		uint32 count = std::thread::hardware_concurrency();
+		for (uint32 i = 1; i < count; i++)
+			jobs_pool.workers.emplace_back(worker_main);
+	}
+}
+
+void Jobs::parallel_for(int count, const std::function<void(int)>& fn)
+{
+	if (count <= 0)
+		return;
+
+	std::call_once(jobs_started, start_workers);
+
+	if (count == 1 || jobs_in_job || jobs_pool.workers.empty())
+	{
+		for (int i = 0; i < count; i++)
+			fn(i);
+		return;
+	}
+
+	std::lock_guard<std::mutex> submit(jobs_pool.submitMutex);
+
+	Batch batch;
+	batch.fn = &fn;
+	batch.count = count;
+
+	{
+		std::lock_guard<std::mutex> lock(jobs_pool.mutex);
+		jobs_pool.batch = &batch;
+		jobs_pool.generation++;
+	}
+	jobs_pool.wake.notify_all();
+
+	run_batch(batch);
+
+	// Wait for stragglers, then make sure no worker can still pick the batch up
+	std::unique_lock<std::mutex> lock(jobs_pool.mutex);
+	jobs_pool.finished.wait(lock, [&]() { return batch.done == batch.count && batch.users == 0; });
+	jobs_pool.batch = nullptr;
+}
+
+uint32 Jobs::worker_count()
+{
+	std::call_once(jobs_started, start_workers);
+	return (uint32)jobs_pool.workers.size() + 1;
+}
@@ -0,0 +1,18 @@
+#pragma once
+
+#include "common.hpp"
+
+#include <functional>
+
+namespace Framework
+{
+	// Persistent worker pool shared by the import and simulation code
+	namespace Jobs
+	{
+		// Runs fn(0..count-1) across the workers and the calling thread, returns
+		// once every index is done. Nested calls run serially on the caller.
+		void parallel_for(int count, const std::function<void(int)>& fn);
+
+		uint32 worker_count();
+	}
+}
@@ -0,0 +1,283 @@
+#include "particles.hpp"
+#include "jobs.hpp"
+#include "stats.hpp"
+
+#include <SDL3/SDL.h>
+
+#include <algorithm>
+
+#if defined(__SSE2__) || defined(_M_X64) || defined(_M_AMD64)
+#include <xmmintrin.h>
+#define PARTICLES_SSE 1
+#endif
+
+using namespace Framework;
+
+ParticleEmitter::ParticleEmitter(const ParticleEmitterDesc& desc, uint32 seed)
+	: desc(desc), rng(seed ? seed : 1)
+{
+	capacity = (desc.capacity + 3) & ~3u;
+	for (auto& stream : streams)
+		stream.resize(capacity, 0.0f);
+
+	Internal::stats_alloc(Stats::Category::Particles, (uint64)capacity * StreamCount * sizeof(float));
+}
+
+ParticleEmitter::~ParticleEmitter()
+{
+	Internal::stats_release(Stats::Category::Particles, (uint64)capacity * StreamCount * sizeof(float));
+}
+
+float ParticleEmitter::random(float min, float max)
+{
+	// xorshift32
+	rng ^= rng << 13;
+	rng ^= rng >> 17;
+	rng ^= rng << 5;
+	return min + (max - min) * ((rng & 0xFFFFFF) / 16777216.0f);
+}
+
+uint32 ParticleEmitter::emit(uint32 count)
+{
+	// desc is public, so the streams' allocated size is the hard limit
+	uint32 limit = std::min(desc.capacity, capacity);
+	count = alive < limit ? std::min(count, limit - alive) : 0;
+
+	for (uint32 n = 0; n < count; n++)
+	{
+		uint32 i = alive++;
+		float lifetime = std::max(random(desc.lifetimeMin, desc.lifetimeMax), 0.0001f);
+
+		streams[PosX][i] = desc.position.x;
+		streams[PosY][i] = desc.position.y;
+		streams[VelX][i] = random(desc.velocityMin.x, desc.velocityMax.x);
+		streams[VelY][i] = random(desc.velocityMin.y, desc.velocityMax.y);
+		streams[ColR][i] = desc.colorStart.x;
+		streams[ColG][i] = desc.colorStart.y;
+		streams[ColB][i] = desc.colorStart.z;
+		streams[ColA][i] = desc.colorStart.w;
+		streams[DColR][i] = (desc.colorEnd.x - desc.colorStart.x) / lifetime;
+		streams[DColG][i] = (desc.colorEnd.y - desc.colorStart.y) / lifetime;
+		streams[DColB][i] = (desc.colorEnd.z - desc.colorStart.z) / lifetime;
+		streams[DColA][i] = (desc.colorEnd.w - desc.colorStart.w) / lifetime;
+		streams[Life][i] = lifetime;
+	}
+
+	return count;
+}
+
+void ParticleEmitter::update(float dt)
+{
+	if (desc.rate > 0.0f)
+	{
+		spawnAccumulator += desc.rate * dt;
+		uint32 spawn = (uint32)spawnAccumulator;
+		spawnAccumulator -= (float)spawn;
+		emit(spawn);
+	}
+
+	integrate(dt);
+	compact();
+}
+
+void ParticleEmitter::integrate(float dt)
+{
+	// Whole groups of 4, the padding past alive is simulated but never drawn
+	uint32 groups = (alive + 3) / 4;
+
+	float* px = streams[PosX].data();
+	float* py = streams[PosY].data();
+	float* vx = streams[VelX].data();
+	float* vy = streams[VelY].data();
+	float* life = streams[Life].data();
+
+#if PARTICLES_SSE
+	const __m128 step = _mm_set1_ps(dt);
+	const __m128 gx = _mm_set1_ps(desc.gravity.x * dt);
+	const __m128 gy = _mm_set1_ps(desc.gravity.y * dt);
+
+	for (uint32 g = 0; g < groups; g++)
+	{
+		uint32 i = g * 4;
+
+		__m128 velX = _mm_add_ps(_mm_loadu_ps(vx + i), gx);
+		__m128 velY = _mm_add_ps(_mm_loadu_ps(vy + i), gy);
+		_mm_storeu_ps(vx + i, velX);
+		_mm_storeu_ps(vy + i, velY);
+		_mm_storeu_ps(px + i, _mm_add_ps(_mm_loadu_ps(px + i), _mm_mul_ps(velX, step)));
+		_mm_storeu_ps(py + i, _mm_add_ps(_mm_loadu_ps(py + i), _mm_mul_ps(velY, step)));
+
+		for (int c = 0; c < 4; c++)
+		{
+			float* color = streams[ColR + c].data() + i;
+			const float* delta = streams[DColR + c].data() + i;
+			_mm_storeu_ps(color, _mm_add_ps(_mm_loadu_ps(color), _mm_mul_ps(_mm_loadu_ps(delta), step)));
+		}
+
+		_mm_storeu_ps(life + i, _mm_sub_ps(_mm_loadu_ps(life + i), step));
+	}
+#else
+	for (uint32 i = 0; i < groups * 4; i++)
+	{
+		vx[i] += desc.gravity.x * dt;
+		vy[i] += desc.gravity.y * dt;
+		px[i] += vx[i] * dt;
+		py[i] += vy[i] * dt;
+
+		for (int c = 0; c < 4; c++)
+			streams[ColR + c][i] += streams[DColR + c][i] * dt;
+
+		life[i] -= dt;
+	}
+#endif
+}
+
+void ParticleEmitter::compact()
+{
+	// Swap-remove: the last live particle takes the dead one's slot
+	float* life = streams[Life].data();
+
+	uint32 i = 0;
+	while (i < alive)
+	{
+		if (life[i] > 0.0f)
+		{
+			i++;
+			continue;
+		}
+
+		uint32 last = --alive;
+		for (auto& stream : streams)
+			stream[i] = stream[last];
+	}
+}
+
+void ParticleEmitter::write_vertices(Vertex* out) const
+{
+	const float half = desc.size * 0.5f;
+	const glm::vec4 mask = VertexMask::Solid;
+
+	for (uint32 i = 0; i < alive; i++)
+	{
+		float x = streams[PosX][i];
+		float y = streams[PosY][i];
+		glm::vec4 color = { streams[ColR][i], streams[ColG][i], streams[ColB][i], streams[ColA][i] };
+
+		glm::vec2 p0 = { x - half, y - half };
+		glm::vec2 p1 = { x + half, y - half };
+		glm::vec2 p2 = { x - half, y + half };
+		glm::vec2 p3 = { x + half, y + half };
+
+		Vertex* quad = out + i * 6;
+		quad[0] = { p0, { 0, 0 }, color, mask };
+		quad[1] = { p1, { 1, 0 }, color, mask };
+		quad[2] = { p2, { 0, 1 }, color, mask };
+		quad[3] = { p1, { 1, 0 }, color, mask };
+		quad[4] = { p3, { 1, 1 }, color, mask };
+		quad[5] = { p2, { 0, 1 }, color, mask };
+	}
+}
+
+ParticleEmitter* ParticleSystem::add_emitter(const ParticleEmitterDesc& desc)
+{
+	emitters.push_back(CreateScope<ParticleEmitter>(desc, (uint32)emitters.size() * 2654435761u + 1));
+	return emitters.back().get();
+}
+
+void ParticleSystem::remove_emitter(ParticleEmitter* emitter)
+{
+	auto it = std::find_if(emitters.begin(), emitters.end(), [&](const Scope<ParticleEmitter>& e) { return e.get() == emitter; });
+	if (it != emitters.end())
+		emitters.erase(it);
+}
+
+void ParticleSystem::update(float dt)
+{
+	Jobs::parallel_for((int)emitters.size(), [&](int i)
+	{
+		emitters[i]->update(dt);
+	});
+}
+
+uint32 ParticleSystem::count() const
+{
+	uint32 total = 0;
+	for (auto& emitter : emitters)
+		total += emitter->count();
+	return total;
+}
+
+uint32 ParticleSystem::vertex_count() const
+{
+	return count() * 6;
+}
+
+void ParticleSystem::write_vertices(Vertex* out) const
+{
+	std::vector<uint32> offsets(emitters.size());
+	uint32 offset = 0;
+	for (size_t i = 0; i < emitters.size(); i++)
+	{
+		offsets[i] = offset;
+		offset += emitters[i]->vertex_count();
+	}
+
+	Jobs::parallel_for((int)emitters.size(), [&](int i)
+	{
+		emitters[i]->write_vertices(out + offsets[i]);
+	});
+}
+
+void Particles::run_benchmark(uint32 particleCount, uint32 frames)
+{
+	const uint32 perEmitter = 16384;
+	const float dt = 1.0f / 60.0f;
+
+	ParticleSystem system;
+	uint32 emitterCount = std::max(1u, (particleCount + perEmitter - 1) / perEmitter);
+
+	for (uint32 i = 0; i < emitterCount; i++)
+	{
+		ParticleEmitterDesc desc;
+		desc.position = { 640.0f, 360.0f };
+		desc.velocityMin = { -200.0f, -300.0f };
+		desc.velocityMax = { 200.0f, -100.0f };
+		desc.gravity = { 0.0f, 400.0f };
+		desc.colorStart = { 1.0f, 0.8f, 0.2f, 1.0f };
+		desc.colorEnd = { 1.0f, 0.1f, 0.0f, 0.0f };
+		desc.lifetimeMin = 1.0f;
+		desc.lifetimeMax = 2.0f;
+		desc.capacity = std::min(perEmitter, particleCount - i * perEmitter);
+
+		// Spawn at the rate that keeps the pool roughly full
+		desc.rate = desc.capacity / 1.5f;
+
+		system.add_emitter(desc)->emit(desc.capacity);
+	}
+
+	std::vector<Vertex> vertices;
+	const double frequency = (double)SDL_GetPerformanceFrequency();
+	double simulateMs = 0.0, emitMs = 0.0;
+	uint64 simulated = 0;
+
+	for (uint32 frame = 0; frame < frames; frame++)
+	{
+		simulated += system.count();
+
+		uint64 start = SDL_GetPerformanceCounter();
+		system.update(dt);
+		uint64 mid = SDL_GetPerformanceCounter();
+
+		vertices.resize(system.vertex_count());
+		system.write_vertices(vertices.data());
+		uint64 end = SDL_GetPerformanceCounter();
+
+		simulateMs += (double)(mid - start) * 1000.0 / frequency;
+		emitMs += (double)(end - mid) * 1000.0 / frequency;
+	}
+
+	SDL_Log("Particles: %u emitters, %u workers, %u frames", emitterCount, Jobs::worker_count(), frames);
+	SDL_Log("Simulate: %.1f particles/ms (%.3f ms/frame)", simulated / simulateMs, simulateMs / frames);
+	SDL_Log("Vertices: %.1f particles/ms (%.3f ms/frame)", simulated / emitMs, emitMs / frames);
+	SDL_Log("Total:    %.1f particles/ms", simulated / (simulateMs + emitMs));
+}
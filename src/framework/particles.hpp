@@ -0,0 +1,95 @@
+#pragma once
+
+#include "common.hpp"
+#include "graphics.hpp"
+
+#include <vector>
+
+namespace Framework
+{
+	struct ParticleEmitterDesc
+	{
+		glm::vec2 position = { 0, 0 };
+		glm::vec2 velocityMin = { -50, -50 };
+		glm::vec2 velocityMax = { 50, 50 };
+		glm::vec2 gravity = { 0, 0 };
+		glm::vec4 colorStart = { 1, 1, 1, 1 };
+		glm::vec4 colorEnd = { 1, 1, 1, 0 };
+		float lifetimeMin = 1.0f;
+		float lifetimeMax = 1.0f;
+		float size = 4.0f;
+		float rate = 0.0f;			// particles per second, 0 = only emit()
+		uint32 capacity = 4096;
+	};
+
+	// Structure-of-arrays particle pool. Every stream is padded to a multiple of
+	// 4 so the simulation runs in whole SIMD groups.
+	class ParticleEmitter
+	{
+	public:
+		ParticleEmitter(const ParticleEmitterDesc& desc, uint32 seed = 1);
+		~ParticleEmitter();
+
+		// Spawns up to count particles, returns how many fit
+		uint32 emit(uint32 count);
+
+		// Spawns from the rate, integrates and removes dead particles
+		void update(float dt);
+
+		uint32 count() const { return alive; }
+
+		uint32 vertex_count() const { return alive * 6; }
+
+		// Writes 6 vertices per live particle
+		void write_vertices(Vertex* out) const;
+
+		ParticleEmitterDesc desc;
+
+	private:
+		enum Stream
+		{
+			PosX, PosY,
+			VelX, VelY,
+			ColR, ColG, ColB, ColA,
+			DColR, DColG, DColB, DColA,
+			Life,
+			StreamCount
+		};
+
+		std::vector<float> streams[StreamCount];
+		uint32 alive = 0;
+		uint32 capacity = 0;
+		float spawnAccumulator = 0.0f;
+		uint32 rng;
+
+		float random(float min, float max);
+		void integrate(float dt);
+		void compact();
+	};
+
+	class ParticleSystem
+	{
+	public:
+		ParticleEmitter* add_emitter(const ParticleEmitterDesc& desc);
+
+		void remove_emitter(ParticleEmitter* emitter);
+
+		// Emitters are independent, so they update in parallel
+		void update(float dt);
+
+		uint32 count() const;
+
+		uint32 vertex_count() const;
+
+		void write_vertices(Vertex* out) const;
+
+	private:
+		std::vector<Scope<ParticleEmitter>> emitters;
+	};
+
+	namespace Particles
+	{
+		// Headless throughput benchmark, logs particles simulated per millisecond
+		void run_benchmark(uint32 particleCount, uint32 frames);
+	}
+}
@@ -2,6 +2,15 @@
 
 #include <glm/glm.hpp>
 #include "graphics.hpp"
+#include "capture.hpp"
+#include "texture_import.hpp"
+#include "dynamic_resolution.hpp"
+
+namespace Framework
+{
+	class ParticleSystem;
+	class Tilemap;
+}
 
 class Renderer
 {
@@ -22,6 +31,28 @@ public:
 
 	virtual void clear_backbuffer(const glm::vec4& color, float depth, uint8_t stencil, ClearMask mask) = 0;
 
+	// Re-issues a captured frame, between before_render and after_render
+	virtual void replay(const Framework::Capture::Frame& frame) = 0;
+
+	// Uploads every mip of an imported image, returns nullptr on failure
+	virtual Texture* create_texture(const Framework::TextureImage& image) = 0;
+
+	// Retained vertex buffer for geometry that rarely changes
+	virtual Mesh* create_mesh() = 0;
+
+	// Top-left of the world-space view
+	virtual void set_camera(const glm::vec2& position) = 0;
+
+	// Queued for the next render and drawn with the scene. The system has to
+	// stay alive until then.
+	virtual void submit_particles(const Framework::ParticleSystem& particles) = 0;
+
+	// Queued like particles. Tilemaps are drawn before particles, as the background.
+	virtual void submit_tilemap(Framework::Tilemap& tilemap) = 0;
+
+	// Renders the scene offscreen at a scale driven by frame time, then upscales
+	virtual void set_dynamic_resolution(const Framework::DynamicResolutionSettings& settings) = 0;
+
 private:
 	static Renderer* try_make_opengl();
 	static Renderer* try_make_d3d11();
@@ -1,12 +1,22 @@
 #include "renderer.hpp"
 #include "app.hpp"
 #include "platform.hpp"
+#include "capture.hpp"
+#include "stats.hpp"
+#include "shapes.hpp"
+#include "particles.hpp"
+#include "tilemap.hpp"
 
+#define NOMINMAX
 #include <windows.h>
 #include <d3d11.h>
 #include <d3dcompiler.h>
 #include <iostream>
 #include <assert.h>
+#include <algorithm>
+#include <chrono>
+#include <unordered_map>
+#include <vector>
 
 #define STB_IMAGE_IMPLEMENTATION
 #include <stb_image.h>
@@ -69,13 +79,6 @@ struct ConstantBuffer {
 	Matrix4x4 Matrix;
 };
 
-struct Vertex {
-	glm::vec2 position;
-	glm::vec2 texCoord;
-	glm::vec4 color;
-	glm::vec4 mask;
-};
-
 static Vertex MakeVertex(glm::vec2 position, glm::vec4 color)
 {
 	return Vertex
@@ -83,7 +86,143 @@ static Vertex MakeVertex(glm::vec2 position, glm::vec4 color)
 		position,
 		{ 0, 0 },
 		color,
-		{ 0, 0, 255, 0 }
+		VertexMask::Solid
+	};
+}
+
+static Vertex MakeVertex(glm::vec2 position, glm::vec2 texCoord, glm::vec4 color, const glm::vec4& mask = VertexMask::Solid)
+{
+	return Vertex
+	{
+		position,
+		texCoord,
+		color,
+		mask
+	};
+}
+
+struct Rect {
+	float x0, y0, x1, y1;
+
+	bool Contains(const Rect& other) const {
+		return other.x0 >= x0 && other.y0 >= y0 && other.x1 <= x1 && other.y1 <= y1;
+	}
+
+	bool Empty() const {
+		return x0 >= x1 || y0 >= y1;
+	}
+
+	bool Overlaps(const Rect& other) const {
+		return !Empty() && !other.Empty() && other.x0 < x1 && other.x1 > x0 && other.y0 < y1 && other.y1 > y0;
+	}
+
+	// Disjoint rects give an empty rect, never an inverted one
+	Rect Intersect(const Rect& other) const {
+		Rect result = { std::max(x0, other.x0), std::max(y0, other.y0), std::min(x1, other.x1), std::min(y1, other.y1) };
+		result.x1 = std::max(result.x1, result.x0);
+		result.y1 = std::max(result.y1, result.y0);
+		return result;
+	}
+};
+
+namespace Framework
+{
+	class Mesh_D3D11 : public Mesh
+	{
+	public:
+		Mesh_D3D11(ID3D11Device* device, ID3D11DeviceContext* context)
+			: device(device), context(context)
+		{
+			static uint32 next_id = 1;
+			id = next_id++;
+		}
+
+		~Mesh_D3D11() override
+		{
+			release();
+		}
+
+		void set_vertices(const Vertex* vertices, uint32_t count) override
+		{
+			revision++;
+
+			if (count > capacity)
+			{
+				release();
+
+				D3D11_BUFFER_DESC desc = {};
+				desc.Usage = D3D11_USAGE_DEFAULT;
+				desc.ByteWidth = sizeof(Vertex) * count;
+				desc.BindFlags = D3D11_BIND_VERTEX_BUFFER;
+
+				D3D11_SUBRESOURCE_DATA data = { vertices, 0, 0 };
+				if (FAILED(device->CreateBuffer(&desc, &data, &buffer)))
+				{
+					buffer = nullptr;
+					vertexCount = 0;
+					return;
+				}
+
+				capacity = count;
+				Internal::stats_alloc(Stats::Category::VertexBuffer, desc.ByteWidth);
+			}
+			else if (count > 0)
+			{
+				D3D11_BOX box = { 0, 0, 0, (UINT)(sizeof(Vertex) * count), 1, 1 };
+				context->UpdateSubresource(buffer, 0, &box, vertices, 0, 0);
+			}
+
+			vertexCount = count;
+		}
+
+		uint32_t vertex_count() const override
+		{
+			return vertexCount;
+		}
+
+		ID3D11Buffer* buffer = nullptr;
+
+		// Identify the contents in captures
+		uint32 id = 0;
+		uint32 revision = 0;
+
+	private:
+		ID3D11Device* device;
+		ID3D11DeviceContext* context;
+		uint32 vertexCount = 0;
+		uint32 capacity = 0;
+
+		void release()
+		{
+			if (!buffer) return;
+
+			buffer->Release();
+			buffer = nullptr;
+			Internal::stats_release(Stats::Category::VertexBuffer, sizeof(Vertex) * capacity);
+			capacity = 0;
+		}
+	};
+
+	class Texture_D3D11 : public Texture
+	{
+	public:
+		ID3D11Texture2D* texture = nullptr;
+		ID3D11ShaderResourceView* view = nullptr;
+		uint64 bytes = 0;
+		Capture::TextureData info = {};
+
+		glm::ivec2 get_size() const override
+		{
+			return { info.width, info.height };
+		}
+
+		~Texture_D3D11() override
+		{
+			if (view) view->Release();
+			if (texture) texture->Release();
+			if (bytes > 0)
+				Internal::stats_release(Stats::Category::Texture, bytes);
+		}
 	};
 }
 
@@ -91,12 +230,17 @@ class DrawingSystem
 {
 public:
 	DrawingSystem(ID3D11Device* device, ID3D11DeviceContext* context)
-		: device(device), context(context), vertexBuffer(nullptr) {
+		: device(device), context(context), vertexBuffer(nullptr), constantBuffer(nullptr), texture(nullptr) {
 		InitBuffer();
 	}
 
 	~DrawingSystem() {
-		if (vertexBuffer) vertexBuffer->Release();
+		ReleaseVertexBuffer();
+		if (constantBuffer) {
+			constantBuffer->Release();
+			Framework::Internal::stats_release(Framework::Stats::Category::ConstantBuffer, sizeof(ConstantBuffer));
+		}
+		Framework::Internal::stats_release(Framework::Stats::Category::CpuVertices, trackedVertexCapacity * sizeof(Vertex));
 	}
 
 	void DrawingSystem::UpdateConstantBuffer(ID3D11DeviceContext* context, const Matrix4x4& matrix) {
@@ -106,40 +250,444 @@ public:
 		context->Unmap(constantBuffer, 0);
 
 		context->VSSetConstantBuffers(0, 1, &constantBuffer);
+
+		if (captureEnabled)
+			Framework::Internal::capture_matrix(&matrix, sizeof(Matrix4x4));
+	}
+
+	// World-space rect mapped onto the viewport
+	void SetView(float x, float y, float width, float height) {
+		Flush();
+
+		viewX = x;
+		viewY = y;
+		viewWidth = width;
+		viewHeight = height;
+		UpdateConstantBuffer(context, CreateOrthographicOffCenter(x, x + width, y + height, y, 0, 1));
+	}
+
+	void SetViewport(float width, float height) {
+		viewportWidth = width;
+		viewportHeight = height;
+		captureWidth = width;
+		captureHeight = height;
+	}
+
+	// Captures replay at the full frame size, so scissors drawn into a smaller
+	// viewport are recorded scaled up to it
+	void SetCaptureSize(float width, float height) {
+		captureWidth = width;
+		captureHeight = height;
+	}
+
+	// Clip rects are in world units, the space of the current view, and nest by intersection
+	void PushClipRect(float x, float y, float width, float height) {
+		Rect rect = { x, y, x + std::max(width, 0.0f), y + std::max(height, 0.0f) };
+		if (!clipStack.empty())
+			rect = rect.Intersect(clipStack.back());
+		clipStack.push_back(rect);
+	}
+
+	void PopClipRect() {
+		if (!clipStack.empty())
+			clipStack.pop_back();
+	}
+
+	// Everything drawn while this is true is dropped
+	bool ClipEmpty() const {
+		return !clipStack.empty() && clipStack.back().Empty();
+	}
+
+	// Texture sampled by Textured vertices, changing it breaks the batch.
+	// info describes it in captures, the default records no texture.
+	void SetTexture(ID3D11ShaderResourceView* view, const Framework::Capture::TextureData& info = {}) {
+		if (view == texture) return;
+
+		Flush();
+		texture = view;
+		textureInfo = info;
+	}
+
+	// Leaves draws out of captures, for passes that depend on GPU-only state
+	void SetCaptureEnabled(bool enabled) {
+		captureEnabled = enabled;
 	}
 
 	void DrawRectangle(float x, float y, float width, float height, glm::vec4 color) {
-		glm::vec2 p1 = { x, y };
-		glm::vec2 p2 = { x + width, y };
-		glm::vec2 p3 = { x, y + height };
-		glm::vec2 p4 = { x + width, y + height };
+		DrawQuad(x, y, width, height, { 0, 0 }, { 1, 1 }, color);
+	}
+
+	void DrawTexture(float x, float y, float width, float height, glm::vec2 uv0, glm::vec2 uv1, glm::vec4 color) {
+		DrawQuad(x, y, width, height, uv0, uv1, color, VertexMask::Textured);
+	}
+
+	// Axis-aligned quads are clipped on the CPU so clipping never breaks the batch
+	void DrawQuad(float x, float y, float width, float height, glm::vec2 uv0, glm::vec2 uv1, glm::vec4 color, const glm::vec4& mask = VertexMask::Solid) {
+		glm::vec2 p0 = { x, y };
+		glm::vec2 p1 = { x + width, y + height };
+
+		if (!clipStack.empty()) {
+			const Rect& clip = clipStack.back();
+			glm::vec2 c0 = { std::max(p0.x, clip.x0), std::max(p0.y, clip.y0) };
+			glm::vec2 c1 = { std::min(p1.x, clip.x1), std::min(p1.y, clip.y1) };
+
+			// Fully clipped
+			if (c0.x >= c1.x || c0.y >= c1.y)
+				return;
+
+			// Move the UVs along with the clipped edges
+			glm::vec2 size = p1 - p0;
+			glm::vec2 uvSize = uv1 - uv0;
+			glm::vec2 t0 = { (c0.x - p0.x) / size.x, (c0.y - p0.y) / size.y };
+			glm::vec2 t1 = { (c1.x - p0.x) / size.x, (c1.y - p0.y) / size.y };
+			uv1 = { uv0.x + uvSize.x * t1.x, uv0.y + uvSize.y * t1.y };
+			uv0 = { uv0.x + uvSize.x * t0.x, uv0.y + uvSize.y * t0.y };
+			p0 = c0;
+			p1 = c1;
+		}
+
+		EnsureScissorContains({ p0.x, p0.y, p1.x, p1.y });
+
+		glm::vec2 p2 = { p1.x, p0.y };
+		glm::vec2 p3 = { p0.x, p1.y };
 
 		Vertex quad[6] = {
-			MakeVertex(p1, color),
-			MakeVertex(p2, color),
-			MakeVertex(p3, color),
-			MakeVertex(p2, color),
-			MakeVertex(p4, color),
-			MakeVertex(p3, color)
+			MakeVertex(p0, uv0, color, mask),
+			MakeVertex(p2, { uv1.x, uv0.y }, color, mask),
+			MakeVertex(p3, { uv0.x, uv1.y }, color, mask),
+			MakeVertex(p2, { uv1.x, uv0.y }, color, mask),
+			MakeVertex(p1, uv1, color, mask),
+			MakeVertex(p3, { uv0.x, uv1.y }, color, mask)
 		};
 		vertices.insert(vertices.end(), std::begin(quad), std::end(quad));
 	}
 
+	// Arbitrary (rotated, non-rectangular) triangles. Only geometry that straddles
+	// the clip rect falls back to the hardware scissor.
+	void DrawTriangles(const Vertex* data, size_t count) {
+		if (count == 0 || ClipEmpty()) return;
+
+		Rect bounds = { data[0].position.x, data[0].position.y, data[0].position.x, data[0].position.y };
+		for (size_t i = 1; i < count; i++) {
+			bounds.x0 = std::min(bounds.x0, data[i].position.x);
+			bounds.y0 = std::min(bounds.y0, data[i].position.y);
+			bounds.x1 = std::max(bounds.x1, data[i].position.x);
+			bounds.y1 = std::max(bounds.y1, data[i].position.y);
+		}
+
+		if (!clipStack.empty()) {
+			const Rect& clip = clipStack.back();
+			if (!clip.Overlaps(bounds))
+				return;
+
+			if (!clip.Contains(bounds))
+				SetScissor(clip);
+			else
+				EnsureScissorContains(bounds);
+		}
+		else {
+			EnsureScissorContains(bounds);
+		}
+
+		vertices.insert(vertices.end(), data, data + count);
+	}
+
+	// Retained geometry, drawn in order with the batch. The source vertices are
+	// only read when a capture is recording.
+	void DrawMesh(const Mesh* mesh, const Vertex* source) {
+		auto d3dMesh = static_cast<const Framework::Mesh_D3D11*>(mesh);
+		UINT count = d3dMesh ? d3dMesh->vertex_count() : 0;
+		if (count == 0 || !d3dMesh->buffer || ClipEmpty()) return;
+
+		ScissorToClip();
+		Flush();
+
+		D3D11_RECT scissor = ScissorPixels();
+
+		if (captureEnabled) {
+			CaptureState(scissor);
+			if (source)
+				Framework::Internal::capture_mesh({ d3dMesh->id, d3dMesh->revision }, source, sizeof(Vertex), count);
+		}
+
+		DrawVertexBuffer(d3dMesh->buffer, count, scissor);
+	}
+
+	// Only chunks overlapping the current view and clip rect are drawn
+	void DrawTilemap(Framework::Tilemap& tilemap) {
+		Rect visible = { viewX, viewY, viewX + viewWidth, viewY + viewHeight };
+		if (!clipStack.empty()) {
+			visible = visible.Intersect(clipStack.back());
+			if (visible.Empty())
+				return;
+		}
+
+		tilemap.visible_chunks({ visible.x0, visible.y0 }, { visible.x1, visible.y1 }, visibleChunks);
+
+		auto tileset = static_cast<const Framework::Texture_D3D11*>(tilemap.get_tileset());
+		if (tileset)
+			SetTexture(tileset->view, tileset->info);
+		else
+			SetTexture(nullptr);
+
+		// Chunks don't keep their vertices, a capture needs them regenerated
+		bool recording = captureEnabled && Framework::Capture::is_recording();
+		for (auto chunk : visibleChunks) {
+			if (recording)
+				tilemap.chunk_vertices(*chunk, scratch);
+			DrawMesh(chunk->mesh, recording ? scratch.data() : nullptr);
+		}
+
+		SetTexture(nullptr);
+	}
+
+	// Reserves count vertices at the end of the batch for the caller to fill in place.
+	// The result is clipped by the hardware scissor and only valid until the next draw call.
+	// Null when the clip rect is empty.
+	Vertex* AllocateVertices(size_t count) {
+		if (ClipEmpty()) return nullptr;
+
+		ScissorToClip();
+
+		auto offset = vertices.size();
+		vertices.resize(offset + count);
+		return vertices.data() + offset;
+	}
+
+	// Particles are written straight into the mapped vertex buffer, skipping the
+	// batch. A capture needs them on the CPU, so they go through the batch then.
+	void DrawParticles(const Framework::ParticleSystem& particles) {
+		uint32 count = particles.vertex_count();
+		if (count == 0 || ClipEmpty()) return;
+
+		if (captureEnabled && Framework::Capture::is_recording()) {
+			particles.write_vertices(AllocateVertices(count));
+			return;
+		}
+
+		ScissorToClip();
+		Flush();
+
+		Vertex* out = MapVertices(count);
+		if (!out) return;
+
+		particles.write_vertices(out);
+		context->Unmap(vertexBuffer, 0);
+
+		DrawVertexBuffer(vertexBuffer, count, ScissorPixels());
+	}
+
+	void DrawLine(glm::vec2 from, glm::vec2 to, float thickness, glm::vec4 color) {
+		float half = thickness * 0.5f;
+
+		// Axis-aligned lines are plain quads and take the CPU clipping path
+		if (from.x == to.x || from.y == to.y) {
+			glm::vec2 p0 = { std::min(from.x, to.x) - (from.x == to.x ? half : 0.0f), std::min(from.y, to.y) - (from.y == to.y ? half : 0.0f) };
+			glm::vec2 p1 = { std::max(from.x, to.x) + (from.x == to.x ? half : 0.0f), std::max(from.y, to.y) + (from.y == to.y ? half : 0.0f) };
+			DrawRectangle(p0.x, p0.y, p1.x - p0.x, p1.y - p0.y, color);
+			return;
+		}
+
+		glm::vec2 direction = glm::normalize(to - from);
+		glm::vec2 normal = glm::vec2(-direction.y, direction.x) * half;
+
+		Vertex quad[6] = {
+			MakeVertex(from + normal, color),
+			MakeVertex(to + normal, color),
+			MakeVertex(from - normal, color),
+			MakeVertex(to + normal, color),
+			MakeVertex(to - normal, color),
+			MakeVertex(from - normal, color)
+		};
+		DrawTriangles(quad, 6);
+	}
+
+	// Mitered polyline, the miter is capped so sharp turns don't spike
+	void DrawPolyline(const glm::vec2* points, size_t count, float thickness, glm::vec4 color, bool closed = false) {
+		if (count < 2) return;
+
+		float half = thickness * 0.5f;
+		size_t segments = closed ? count : count - 1;
+
+		auto normalOf = [&](size_t i) {
+			glm::vec2 d = points[(i + 1) % count] - points[i];
+			float length = glm::length(d);
+			return length > 0.0f ? glm::vec2(-d.y, d.x) / length : glm::vec2(0.0f, 0.0f);
+		};
+
+		scratch.clear();
+		glm::vec2 prevLeft, prevRight;
+
+		for (size_t i = 0; i <= segments; i++) {
+			size_t index = i % count;
+
+			// Offset direction at this point from the adjoining segment normals
+			glm::vec2 offset;
+			bool hasPrev = closed || i > 0;
+			bool hasNext = closed || i < segments;
+			if (hasPrev && hasNext) {
+				glm::vec2 n0 = normalOf((index + count - 1) % count);
+				glm::vec2 n1 = normalOf(index);
+				glm::vec2 miter = n0 + n1;
+				float length = glm::length(miter);
+				if (length > 0.0001f) {
+					miter = miter / length;
+					float scale = std::min(1.0f / std::max(glm::dot(miter, n1), 0.0001f), 4.0f);
+					offset = miter * (half * scale);
+				}
+				else {
+					offset = n1 * half;
+				}
+			}
+			else {
+				offset = normalOf(hasNext ? index : index - 1) * half;
+			}
+
+			glm::vec2 left = points[index] + offset;
+			glm::vec2 right = points[index] - offset;
+
+			if (i > 0) {
+				scratch.push_back(MakeVertex(prevLeft, color));
+				scratch.push_back(MakeVertex(left, color));
+				scratch.push_back(MakeVertex(prevRight, color));
+				scratch.push_back(MakeVertex(left, color));
+				scratch.push_back(MakeVertex(right, color));
+				scratch.push_back(MakeVertex(prevRight, color));
+			}
+
+			prevLeft = left;
+			prevRight = right;
+		}
+
+		DrawTriangles(scratch.data(), scratch.size());
+	}
+
+	void DrawCircle(glm::vec2 center, float radius, glm::vec4 color) {
+		const auto& circle = Framework::Shapes::unit_circle(SegmentsFor(radius));
+
+		scratch.clear();
+		for (size_t i = 0; i < circle.size(); i++) {
+			const glm::vec2& a = circle[i];
+			const glm::vec2& b = circle[(i + 1) % circle.size()];
+			scratch.push_back(MakeVertex(center, color));
+			scratch.push_back(MakeVertex(center + a * radius, color));
+			scratch.push_back(MakeVertex(center + b * radius, color));
+		}
+
+		DrawTriangles(scratch.data(), scratch.size());
+	}
+
+	void DrawCircleOutline(glm::vec2 center, float radius, float thickness, glm::vec4 color) {
+		const auto& circle = Framework::Shapes::unit_circle(SegmentsFor(radius));
+		float inner = std::max(radius - thickness * 0.5f, 0.0f);
+		float outer = radius + thickness * 0.5f;
+
+		scratch.clear();
+		for (size_t i = 0; i < circle.size(); i++) {
+			const glm::vec2& a = circle[i];
+			const glm::vec2& b = circle[(i + 1) % circle.size()];
+			scratch.push_back(MakeVertex(center + a * inner, color));
+			scratch.push_back(MakeVertex(center + a * outer, color));
+			scratch.push_back(MakeVertex(center + b * outer, color));
+			scratch.push_back(MakeVertex(center + b * outer, color));
+			scratch.push_back(MakeVertex(center + b * inner, color));
+			scratch.push_back(MakeVertex(center + a * inner, color));
+		}
+
+		DrawTriangles(scratch.data(), scratch.size());
+	}
+
+	void DrawRoundedRectangle(float x, float y, float width, float height, float radius, glm::vec4 color) {
+		radius = std::min(radius, std::min(width, height) * 0.5f);
+		if (radius <= 0.0f) {
+			DrawRectangle(x, y, width, height, color);
+			return;
+		}
+
+		// Corners are quarters of the cached circle, which is always a multiple of 4 segments
+		const auto& circle = Framework::Shapes::unit_circle(SegmentsFor(radius));
+		size_t quarter = circle.size() / 4;
+
+		const glm::vec2 corners[4] = {
+			{ x + width - radius, y + height - radius },
+			{ x + radius, y + height - radius },
+			{ x + radius, y + radius },
+			{ x + width - radius, y + radius },
+		};
+
+		glm::vec2 center = { x + width * 0.5f, y + height * 0.5f };
+
+		// The outline is convex, so a fan from the center covers it
+		scratch.clear();
+		glm::vec2 first = corners[0] + circle[0] * radius;
+		glm::vec2 prev = first;
+		for (size_t corner = 0; corner < 4; corner++) {
+			for (size_t i = 0; i <= quarter; i++) {
+				glm::vec2 point = corners[corner] + circle[(corner * quarter + i) % circle.size()] * radius;
+				if (corner > 0 || i > 0) {
+					scratch.push_back(MakeVertex(center, color));
+					scratch.push_back(MakeVertex(prev, color));
+					scratch.push_back(MakeVertex(point, color));
+				}
+				prev = point;
+			}
+		}
+		scratch.push_back(MakeVertex(center, color));
+		scratch.push_back(MakeVertex(prev, color));
+		scratch.push_back(MakeVertex(first, color));
+
+		DrawTriangles(scratch.data(), scratch.size());
+	}
+
+	// Replays a retained mesh draw with a captured scissor
+	void SubmitMesh(const Framework::Mesh_D3D11* mesh, const D3D11_RECT& scissor) {
+		if (!mesh->buffer || mesh->vertex_count() == 0) return;
+
+		DrawVertexBuffer(mesh->buffer, mesh->vertex_count(), scissor);
+	}
+
+	void SubmitVertices(const void* data, size_t count) {
+		auto offset = vertices.size();
+		vertices.resize(offset + count);
+		memcpy(&vertices[offset], data, sizeof(Vertex) * count);
+	}
+
 	void Flush() {
+		Submit(ScissorPixels());
+	}
+
+	void ResetScissor() {
+		Flush();
+		scissorActive = false;
+	}
+
+	void Submit(const D3D11_RECT& scissor) {
 		if (vertices.empty()) return;
 
-		// context->PSSetShaderResources(0, 1, &texture);
+		if (captureEnabled) {
+			CaptureState(scissor);
+			Framework::Internal::capture_draw(vertices.data(), sizeof(Vertex), static_cast<uint32>(vertices.size()));
+		}
+
+		// Without a buffer the batch can't be drawn, drop it rather than crash
+		Vertex* mapped = MapVertices(vertices.size());
+		if (!mapped) {
+			vertices.clear();
+			return;
+		}
 
 		// Update dynamic vertex buffer
-		D3D11_MAPPED_SUBRESOURCE mappedResource;
-		context->Map(vertexBuffer, 0, D3D11_MAP_WRITE_DISCARD, 0, &mappedResource);
-		memcpy(mappedResource.pData, vertices.data(), sizeof(Vertex) * vertices.size());
+		memcpy(mapped, vertices.data(), sizeof(Vertex) * vertices.size());
 		context->Unmap(vertexBuffer, 0);
 
-		// Set buffer and draw
-		UINT stride = sizeof(Vertex), offset = 0;
-		context->IASetVertexBuffers(0, 1, &vertexBuffer, &stride, &offset);
-		context->Draw(static_cast<UINT>(vertices.size()), 0);
+		DrawVertexBuffer(vertexBuffer, vertices.size(), scissor);
+
+		// The CPU-side batch only ever grows, so this is where its footprint changes
+		if (vertices.capacity() != trackedVertexCapacity) {
+			Framework::Internal::stats_resize(Framework::Stats::Category::CpuVertices,
+				trackedVertexCapacity * sizeof(Vertex), vertices.capacity() * sizeof(Vertex));
+			trackedVertexCapacity = vertices.capacity();
+		}
 
 		vertices.clear();
 	}
@@ -150,19 +698,148 @@ private:
 	ID3D11Buffer* vertexBuffer;
 	ID3D11Buffer* constantBuffer;
 	ID3D11ShaderResourceView* texture;
+	Framework::Capture::TextureData textureInfo = {};
+	bool captureEnabled = true;
+
+	size_t vertexBufferCapacity = 0;
 
 	std::vector<Vertex> vertices;
-	const float screenWidth = 1280;
-	const float screenHeight = 720;
+	size_t trackedVertexCapacity = 0;
+	float viewX = 0;
+	float viewY = 0;
+	float viewWidth = 1280;
+	float viewHeight = 720;
+
+	float viewportWidth = 1280;
+	float viewportHeight = 720;
+	float captureWidth = 1280;
+	float captureHeight = 720;
+	std::vector<Rect> clipStack;
+	std::vector<Vertex> scratch;
+	std::vector<const Framework::Tilemap::Chunk*> visibleChunks;
+	bool scissorActive = false;
+	Rect scissorRect = {};
+
+	// Circle detail from the radius in viewport pixels
+	uint32 SegmentsFor(float radius) const {
+		float scale = std::max(viewportWidth / viewWidth, viewportHeight / viewHeight);
+		return Framework::Shapes::segments_for_radius(radius * scale);
+	}
 
-	void InitBuffer() {
+	// Hardware scissor in viewport pixels, or the whole viewport when inactive
+	D3D11_RECT ScissorPixels() const {
+		if (!scissorActive)
+			return { 0, 0, (LONG)viewportWidth, (LONG)viewportHeight };
+
+		float sx = viewportWidth / viewWidth;
+		float sy = viewportHeight / viewHeight;
+		return {
+			(LONG)floorf((scissorRect.x0 - viewX) * sx),
+			(LONG)floorf((scissorRect.y0 - viewY) * sy),
+			(LONG)ceilf((scissorRect.x1 - viewX) * sx),
+			(LONG)ceilf((scissorRect.y1 - viewY) * sy)
+		};
+	}
+
+	// Every captured draw is preceded by the state it depends on
+	void CaptureState(const D3D11_RECT& scissor) {
+		D3D11_RECT captured = CaptureScissor(scissor);
+		Framework::Internal::capture_scissor(&captured, sizeof(D3D11_RECT));
+		Framework::Internal::capture_texture(textureInfo);
+	}
+
+	D3D11_RECT CaptureScissor(const D3D11_RECT& scissor) const {
+		if (captureWidth == viewportWidth && captureHeight == viewportHeight)
+			return scissor;
+
+		float sx = captureWidth / viewportWidth;
+		float sy = captureHeight / viewportHeight;
+		return {
+			(LONG)floorf(scissor.left * sx),
+			(LONG)floorf(scissor.top * sy),
+			(LONG)ceilf(scissor.right * sx),
+			(LONG)ceilf(scissor.bottom * sy)
+		};
+	}
+
+	void SetScissor(const Rect& rect) {
+		if (scissorActive && scissorRect.Contains(rect) && rect.Contains(scissorRect))
+			return;
+
+		Flush();
+		scissorActive = true;
+		scissorRect = rect;
+	}
+
+	// Batched geometry must not be cut by a scissor left over from earlier content
+	void EnsureScissorContains(const Rect& bounds) {
+		if (!scissorActive || scissorRect.Contains(bounds))
+			return;
+
+		Flush();
+		scissorActive = false;
+	}
+
+	// Geometry that can't be clipped on the CPU takes the hardware scissor
+	void ScissorToClip() {
+		if (!clipStack.empty())
+			SetScissor(clipStack.back());
+		else if (scissorActive)
+			ResetScissor();
+	}
+
+	// Grows the GPU buffer to fit count vertices and maps it for writing,
+	// null when no buffer could be created
+	Vertex* MapVertices(size_t count) {
+		if (count > vertexBufferCapacity) {
+			size_t capacity = std::max(vertexBufferCapacity, (size_t)1);
+			while (capacity < count)
+				capacity *= 2;
+
+			ReleaseVertexBuffer();
+			CreateVertexBuffer(capacity);
+		}
+
+		D3D11_MAPPED_SUBRESOURCE mappedResource;
+		if (!vertexBuffer || FAILED(context->Map(vertexBuffer, 0, D3D11_MAP_WRITE_DISCARD, 0, &mappedResource)))
+			return nullptr;
+
+		return static_cast<Vertex*>(mappedResource.pData);
+	}
+
+	void DrawVertexBuffer(ID3D11Buffer* buffer, size_t count, const D3D11_RECT& scissor) {
+		context->RSSetScissorRects(1, &scissor);
+		context->PSSetShaderResources(0, 1, &texture);
+
+		UINT stride = sizeof(Vertex), offset = 0;
+		context->IASetVertexBuffers(0, 1, &buffer, &stride, &offset);
+		context->Draw(static_cast<UINT>(count), 0);
+	}
+
+	void CreateVertexBuffer(size_t capacity) {
 		D3D11_BUFFER_DESC bufferDesc = {};
 		bufferDesc.Usage = D3D11_USAGE_DYNAMIC;
-		bufferDesc.ByteWidth = sizeof(Vertex) * 1024;  // Initial size, can be adjusted
+		bufferDesc.ByteWidth = static_cast<UINT>(sizeof(Vertex) * capacity);
 		bufferDesc.BindFlags = D3D11_BIND_VERTEX_BUFFER;
 		bufferDesc.CPUAccessFlags = D3D11_CPU_ACCESS_WRITE;
 
-		device->CreateBuffer(&bufferDesc, nullptr, &vertexBuffer);
+		if (SUCCEEDED(device->CreateBuffer(&bufferDesc, nullptr, &vertexBuffer))) {
+			vertexBufferCapacity = capacity;
+			Framework::Internal::stats_alloc(Framework::Stats::Category::VertexBuffer, bufferDesc.ByteWidth);
+		}
+	}
+
+	void ReleaseVertexBuffer() {
+		if (!vertexBuffer) return;
+
+		vertexBuffer->Release();
+		vertexBuffer = nullptr;
+		Framework::Internal::stats_release(Framework::Stats::Category::VertexBuffer, sizeof(Vertex) * vertexBufferCapacity);
+		vertexBufferCapacity = 0;
+	}
+
+	void InitBuffer() {
+		CreateVertexBuffer(1024);  // Initial size, grows in Flush
 
 		D3D11_BUFFER_DESC cbd = {};
 		cbd.Usage = D3D11_USAGE_DYNAMIC;
@@ -170,7 +847,8 @@ private:
 		cbd.BindFlags = D3D11_BIND_CONSTANT_BUFFER;
 		cbd.CPUAccessFlags = D3D11_CPU_ACCESS_WRITE;
 
-		device->CreateBuffer(&cbd, nullptr, &constantBuffer);
+		if (SUCCEEDED(device->CreateBuffer(&cbd, nullptr, &constantBuffer)))
+			Framework::Internal::stats_alloc(Framework::Stats::Category::ConstantBuffer, sizeof(ConstantBuffer));
 	}
 };
 
@@ -186,6 +864,13 @@ namespace Framework
 		void after_render() override;
 		void render(const DrawCall& drawCall) override;
 		void clear_backbuffer(const glm::vec4& color, float depth, uint8_t stencil, ClearMask mask) override;
+		void replay(const Capture::Frame& frame) override;
+		Texture* create_texture(const TextureImage& image) override;
+		Mesh* create_mesh() override;
+		void set_camera(const glm::vec2& position) override;
+		void submit_particles(const ParticleSystem& particles) override;
+		void submit_tilemap(Tilemap& tilemap) override;
+		void set_dynamic_resolution(const DynamicResolutionSettings& settings) override;
 
 	private:
 		ID3D11Device* device = nullptr;
@@ -197,9 +882,47 @@ namespace Framework
 		ID3D11VertexShader* vertexShader = nullptr;
 		ID3D11PixelShader* pixelShader = nullptr;
 		ID3D11InputLayout* inputLayout = nullptr;
+		ID3D11RasterizerState* rasterizerState = nullptr;
+		ID3D11SamplerState* samplerState = nullptr;
+		ID3D11BlendState* blendState = nullptr;
+		ID3D11Buffer* uvClampBuffer = nullptr;
+
+		// Offscreen scene target for dynamic resolution, sized to the window
+		ID3D11Texture2D* sceneTexture = nullptr;
+		ID3D11RenderTargetView* sceneView = nullptr;
+		ID3D11ShaderResourceView* sceneResource = nullptr;
+		glm::ivec2 sceneTargetSize = { 0, 0 };
+		uint64 sceneTargetBytes = 0;
+
+		void set_rasterizer_state(const glm::ivec2& size);
+		bool ensure_scene_target(const glm::ivec2& size);
+		void release_scene_target();
+		void set_uv_clamp(const glm::vec4& clamp);
+
+		// Stand-ins for the textures and meshes named in a capture, kept across
+		// replays so each is created and uploaded once
+		std::unordered_map<uint32, Scope<Texture>> replayTextures;
+		std::unordered_map<uint64, Scope<Mesh_D3D11>> replayMeshes;
+		std::vector<Vertex> replayVertices;
+
+		Texture_D3D11* replay_texture(const Capture::TextureData& data);
 
 	private:
 		glm::ivec2 lastWindowSize;
+		uint64 backBufferBytes = 0;
+		glm::vec2 cameraPosition = { 0, 0 };
+		glm::vec4 clearColor = { 0, 0, 0, 1 };
+
+		DynamicResolution dynamicResolution;
+		std::chrono::steady_clock::time_point lastPresent;
+		bool hasLastPresent = false;
+		float lastFrameMs = 0.0f;
+
+		std::vector<const ParticleSystem*> submittedParticles;
+		std::vector<Tilemap*> submittedTilemaps;
+		ParticleSystem testParticles;
+		Scope<Tilemap> testTilemap;
+		Scope<Texture> testTileset;
 	};
 
 	ID3DBlob* CompileShader(const wchar_t* file, const char* entry, const char* profile) {
@@ -267,6 +990,12 @@ bool Renderer_D3D11::init()
 	if (backBuffer)
 	{
 		device->CreateRenderTargetView(backBuffer, nullptr, &backBufferView);
+
+		D3D11_TEXTURE2D_DESC desc;
+		backBuffer->GetDesc(&desc);
+		backBufferBytes = (uint64)desc.Width * desc.Height * 4;
+		Internal::stats_alloc(Stats::Category::RenderTarget, backBufferBytes);
+
 		backBuffer->Release();
 	}
 
@@ -316,9 +1045,116 @@ bool Renderer_D3D11::init()
 	  1.0f };
 	context->RSSetViewports(1, &viewport);
 
+	// Rasterizer with scissor enabled, the drawing system keeps the scissor rect
+	// covering the viewport unless clipped content needs it
+	{
+		D3D11_RASTERIZER_DESC desc = {};
+		desc.FillMode = D3D11_FILL_SOLID;
+		desc.CullMode = D3D11_CULL_NONE;
+		desc.ScissorEnable = TRUE;
+		desc.DepthClipEnable = TRUE;
+
+		hr = device->CreateRasterizerState(&desc, &rasterizerState);
+		assert(SUCCEEDED(hr));
+	}
+
+	// Linear clamp sampler for the batcher's texture slot
+	{
+		D3D11_SAMPLER_DESC desc = {};
+		desc.Filter = D3D11_FILTER_MIN_MAG_MIP_LINEAR;
+		desc.AddressU = D3D11_TEXTURE_ADDRESS_CLAMP;
+		desc.AddressV = D3D11_TEXTURE_ADDRESS_CLAMP;
+		desc.AddressW = D3D11_TEXTURE_ADDRESS_CLAMP;
+		desc.MaxLOD = D3D11_FLOAT32_MAX;
+
+		hr = device->CreateSamplerState(&desc, &samplerState);
+		assert(SUCCEEDED(hr));
+		context->PSSetSamplers(0, 1, &samplerState);
+	}
+
+	// Pixel shader UV clamp, only narrowed for the upscale pass
+	{
+		D3D11_BUFFER_DESC desc = {};
+		desc.Usage = D3D11_USAGE_DEFAULT;
+		desc.ByteWidth = sizeof(glm::vec4);
+		desc.BindFlags = D3D11_BIND_CONSTANT_BUFFER;
+
+		glm::vec4 clamp = { 0, 0, 1, 1 };
+		D3D11_SUBRESOURCE_DATA data = { &clamp, 0, 0 };
+		hr = device->CreateBuffer(&desc, &data, &uvClampBuffer);
+		assert(SUCCEEDED(hr));
+		context->PSSetConstantBuffers(1, 1, &uvClampBuffer);
+		Internal::stats_alloc(Stats::Category::ConstantBuffer, sizeof(glm::vec4));
+	}
+
+	// Straight alpha blending, destination alpha stays opaque
+	{
+		D3D11_BLEND_DESC desc = {};
+		auto& target = desc.RenderTarget[0];
+		target.BlendEnable = TRUE;
+		target.SrcBlend = D3D11_BLEND_SRC_ALPHA;
+		target.DestBlend = D3D11_BLEND_INV_SRC_ALPHA;
+		target.BlendOp = D3D11_BLEND_OP_ADD;
+		target.SrcBlendAlpha = D3D11_BLEND_ONE;
+		target.DestBlendAlpha = D3D11_BLEND_INV_SRC_ALPHA;
+		target.BlendOpAlpha = D3D11_BLEND_OP_ADD;
+		target.RenderTargetWriteMask = D3D11_COLOR_WRITE_ENABLE_ALL;
+
+		hr = device->CreateBlendState(&desc, &blendState);
+		assert(SUCCEEDED(hr));
+	}
+
 	// Create drawing system
 	test_drawer = new DrawingSystem(device, context);
 
+	// Test fountain, fades out through colorEnd's alpha
+	{
+		ParticleEmitterDesc desc;
+		desc.position = { 200.0f, 600.0f };
+		desc.velocityMin = { -60.0f, -320.0f };
+		desc.velocityMax = { 60.0f, -220.0f };
+		desc.gravity = { 0.0f, 300.0f };
+		desc.colorStart = { 1.0f, 0.8f, 0.2f, 1.0f };
+		desc.colorEnd = { 1.0f, 0.1f, 0.0f, 0.0f };
+		desc.lifetimeMin = 1.0f;
+		desc.lifetimeMax = 1.5f;
+		desc.rate = 400.0f;
+		desc.capacity = 1024;
+		testParticles.add_emitter(desc);
+	}
+
+	// Test tilemap on a generated 4x4 atlas of bordered 16px tiles
+	{
+		const int atlas = 64, cell = 16;
+		std::vector<uint8> pixels((size_t)atlas * atlas * 4);
+		for (int y = 0; y < atlas; y++)
+		{
+			for (int x = 0; x < atlas; x++)
+			{
+				int tile = (y / cell) * 4 + (x / cell);
+				bool border = x % cell == 0 || y % cell == 0 || x % cell == cell - 1 || y % cell == cell - 1;
+				uint8* p = &pixels[((size_t)y * atlas + x) * 4];
+				p[0] = border ? 30 : (uint8)(60 + (tile % 4) * 60);
+				p[1] = border ? 30 : (uint8)(60 + (tile / 4) * 60);
+				p[2] = border ? 30 : 140;
+				p[3] = 255;
+			}
+		}
+
+		TextureImage image;
+		if (TextureImport::import_rgba(pixels.data(), atlas, atlas, {}, image))
+			testTileset.reset(create_texture(image));
+
+		testTilemap = CreateScope<Tilemap>(this, 14, 10, 32.0f, 8);
+		testTilemap->set_tileset(testTileset.get(), 4, 4);
+		testTilemap->set_position({ 800.0f, 300.0f });
+		for (int y = 0; y < 10; y++)
+		{
+			for (int x = 0; x < 14; x++)
+				testTilemap->set_tile(x, y, (uint16)((x * 7 + y * 3) % 16));
+		}
+	}
+
 	lastWindowSize = App::get_size();
 
 	return true;
@@ -326,7 +1162,27 @@ bool Renderer_D3D11::init()
 
 void Renderer_D3D11::shutdown()
 {
+	DeleteAndNullify(test_drawer);
+
+	testTilemap.reset();
+	testTileset.reset();
+	replayTextures.clear();
+	replayMeshes.clear();
+
+	release_scene_target();
+
 	// Release shaders
+	if (blendState)
+		blendState->Release();
+	if (uvClampBuffer)
+	{
+		uvClampBuffer->Release();
+		Internal::stats_release(Stats::Category::ConstantBuffer, sizeof(glm::vec4));
+	}
+	if (samplerState)
+		samplerState->Release();
+	if (rasterizerState)
+		rasterizerState->Release();
 	inputLayout->Release();
 	vertexShader->Release();
 	pixelShader->Release();
@@ -334,6 +1190,8 @@ void Renderer_D3D11::shutdown()
 	// Release main devices
 	if (backBufferView)
 		backBufferView->Release();
+	Internal::stats_release(Stats::Category::RenderTarget, backBufferBytes);
+	backBufferBytes = 0;
 	swapChain->Release();
 	context->ClearState();
 	context->Flush();
@@ -355,6 +1213,9 @@ void Renderer_D3D11::before_render()
 	{
 		lastWindowSize = nextWindowSize;
 
+		// Frame times from the old size say nothing about the new one
+		dynamicResolution.reset();
+
 		// Release old buffer
 		if (backBufferView)
 			backBufferView->Release();
@@ -369,8 +1230,12 @@ void Renderer_D3D11::before_render()
 		if (SUCCEEDED(hr) && backBuffer)
 		{
 			// Get backbuffer drawable size
-			// D3D11_TEXTURE2D_DESC desc;
-			// backBuffer->GetDesc(&desc);
+			D3D11_TEXTURE2D_DESC desc;
+			backBuffer->GetDesc(&desc);
+
+			uint64 nextBackBufferBytes = (uint64)desc.Width * desc.Height * 4;
+			Internal::stats_resize(Stats::Category::RenderTarget, backBufferBytes, nextBackBufferBytes);
+			backBufferBytes = nextBackBufferBytes;
 
 			// Create view
 			hr = device->CreateRenderTargetView(backBuffer, nullptr, &backBufferView);
@@ -378,52 +1243,232 @@ void Renderer_D3D11::before_render()
 			backBuffer->Release();
 		}
 	}
+
+	Internal::capture_frame_begin(lastWindowSize);
 }
 
 void Renderer_D3D11::after_render()
 {
+	Internal::capture_frame_end();
+	Internal::stats_frame_end();
+
 	auto vsync = false;
 	auto hr = swapChain->Present(vsync ? 1 : 0, 0);
 	assert(SUCCEEDED(hr), "Failed to present swap chain");
+
+	// Present to present is the frame time the resolution controller works from
+	auto now = std::chrono::steady_clock::now();
+	if (hasLastPresent)
+	{
+		lastFrameMs = std::chrono::duration<float, std::milli>(now - lastPresent).count();
+		if (dynamicResolution.get_settings().enabled)
+			dynamicResolution.add_frame_time(lastFrameMs);
+	}
+	lastPresent = now;
+	hasLastPresent = true;
 }
 
-void Renderer_D3D11::render(const DrawCall& pass)
+void Renderer_D3D11::set_rasterizer_state(const glm::ivec2& size)
 {
-	// RS
+	// Set the viewport
 	{
-		// Set the viewport
-		{
+		D3D11_VIEWPORT viewport = { 0.0f, 0.0f, (FLOAT)size.x, (FLOAT)size.y, 0.0f, 1.0f };
+		context->RSSetViewports(1, &viewport);
+		test_drawer->SetViewport((float)size.x, (float)size.y);
+	}
 
-		}
+	// Scissor rect
+	{
+		test_drawer->ResetScissor();
+	}
 
-		// Scissor rect
-		{
+	// Rasterizer
+	{
+		context->RSSetState(rasterizerState);
+	}
+}
 
-		}
+bool Renderer_D3D11::ensure_scene_target(const glm::ivec2& size)
+{
+	if (sceneView && sceneTargetSize == size)
+		return true;
+
+	release_scene_target();
+
+	D3D11_TEXTURE2D_DESC desc = {};
+	desc.Width = size.x;
+	desc.Height = size.y;
+	desc.MipLevels = 1;
+	desc.ArraySize = 1;
+	desc.Format = DXGI_FORMAT_B8G8R8A8_UNORM;
+	desc.SampleDesc.Count = 1;
+	desc.Usage = D3D11_USAGE_DEFAULT;
+	desc.BindFlags = D3D11_BIND_RENDER_TARGET | D3D11_BIND_SHADER_RESOURCE;
+
+	HRESULT hr = device->CreateTexture2D(&desc, nullptr, &sceneTexture);
+	if (SUCCEEDED(hr))
+		hr = device->CreateRenderTargetView(sceneTexture, nullptr, &sceneView);
+	if (SUCCEEDED(hr))
+		hr = device->CreateShaderResourceView(sceneTexture, nullptr, &sceneResource);
+
+	if (FAILED(hr))
+	{
+		release_scene_target();
+		return false;
+	}
 
-		// Rasterizer
-		{
+	sceneTargetSize = size;
+	sceneTargetBytes = (uint64)size.x * size.y * 4;
+	Internal::stats_alloc(Stats::Category::RenderTarget, sceneTargetBytes);
 
-		}
+	return true;
+}
+
+void Renderer_D3D11::set_uv_clamp(const glm::vec4& clamp)
+{
+	context->UpdateSubresource(uvClampBuffer, 0, nullptr, &clamp, 0, 0);
+}
+
+void Renderer_D3D11::release_scene_target()
+{
+	if (sceneResource) { sceneResource->Release(); sceneResource = nullptr; }
+	if (sceneView) { sceneView->Release(); sceneView = nullptr; }
+	if (sceneTexture) { sceneTexture->Release(); sceneTexture = nullptr; }
+
+	if (sceneTargetBytes > 0)
+		Internal::stats_release(Stats::Category::RenderTarget, sceneTargetBytes);
+	sceneTargetBytes = 0;
+	sceneTargetSize = { 0, 0 };
+}
+
+void Renderer_D3D11::render(const DrawCall& pass)
+{
+	const auto& resolution = dynamicResolution.get_settings();
+
+	// Scene size, scaled down when the dynamic resolution controller asks for it
+	glm::ivec2 sceneSize = lastWindowSize;
+	bool scaled = resolution.enabled && ensure_scene_target(lastWindowSize);
+	if (scaled)
+	{
+		float scale = dynamicResolution.scale();
+		sceneSize = { std::max((int)(lastWindowSize.x * scale + 0.5f), 1), std::max((int)(lastWindowSize.y * scale + 0.5f), 1) };
+
+		float color[4] = { clearColor.r, clearColor.g, clearColor.b, clearColor.a };
+		context->OMSetRenderTargets(1, &sceneView, nullptr);
+		context->ClearRenderTargetView(sceneView, color);
 	}
+	else
+	{
+		context->OMSetRenderTargets(1, &backBufferView, nullptr);
+	}
+
+	// RS
+	set_rasterizer_state(sceneSize);
+	test_drawer->SetCaptureSize((float)lastWindowSize.x, (float)lastWindowSize.y);
+
+	// Output merger
+	context->OMSetBlendState(blendState, nullptr, 0xFFFFFFFF);
 
 	// Input assembler
 	context->IASetPrimitiveTopology(D3D11_PRIMITIVE_TOPOLOGY_TRIANGLELIST);
 	context->IASetInputLayout(inputLayout);
 
-	auto stdmax = 24043493898349;
-	test_drawer->UpdateConstantBuffer(context, CreateOrthographicOffCenter(0, 1280, 720, 0, 0, stdmax));
+	test_drawer->SetView(cameraPosition.x, cameraPosition.y, (float)lastWindowSize.x, (float)lastWindowSize.y);
 
 	// Draw rectangles
 	test_drawer->DrawRectangle(100, 100, 50, 50, { 1, 0, 0, 1 }); // Red rectangle
 	test_drawer->DrawRectangle(200, 100, 50, 50, { 1, 1, 0, 1 }); // Yellow rectangle
 	test_drawer->DrawRectangle(300, 100, 50, 50, { 1, 1, 1, 1 }); // White rectangle
 
+	// Clipped list: the rows run past the panel and are cut on the CPU, the
+	// diagonal line and the circle in the nested clip straddle it and take the scissor
+	test_drawer->DrawRectangle(500, 80, 240, 160, { 0.2f, 0.2f, 0.2f, 1 });
+	test_drawer->PushClipRect(510, 90, 220, 140);
+	for (int i = 0; i < 8; i++)
+		test_drawer->DrawRectangle(490, 70 + i * 24.0f, 180, 18, i % 2 ? glm::vec4{ 0.3f, 0.5f, 0.9f, 1 } : glm::vec4{ 0.9f, 0.6f, 0.2f, 1 });
+	test_drawer->DrawLine({ 480, 250 }, { 760, 60 }, 6, { 1, 1, 1, 1 });
+	test_drawer->PushClipRect(680, 60, 100, 100);
+	test_drawer->DrawCircle({ 720, 120 }, 40, { 0.9f, 0.2f, 0.3f, 1 });
+	test_drawer->PopClipRect();
+	test_drawer->PopClipRect();
+
+	// Simulated with the last frame's time, capped so a stall doesn't explode it
+	testParticles.update(std::min(lastFrameMs, 100.0f) / 1000.0f);
+	submit_particles(testParticles);
+
+	submit_tilemap(*testTilemap);
+
+	for (auto tilemap : submittedTilemaps)
+		test_drawer->DrawTilemap(*tilemap);
+	submittedTilemaps.clear();
+
+	for (auto particles : submittedParticles)
+		test_drawer->DrawParticles(*particles);
+	submittedParticles.clear();
+
 	test_drawer->Flush();
+
+	// Debug overlay with the current render scale and frame time
+	auto drawUI = [&]()
+	{
+		test_drawer->SetView(0, 0, (float)lastWindowSize.x, (float)lastWindowSize.y);
+
+		const float x = 16, y = 16, width = 208, bar = 200;
+		float scale = scaled ? dynamicResolution.scale() : 1.0f;
+		float frame = std::min(lastFrameMs / std::max(resolution.targetFrameMs, 0.001f), 1.0f);
+
+		test_drawer->DrawRoundedRectangle(x, y, width, 40, 6, { 0.1f, 0.1f, 0.1f, 1 });
+		test_drawer->DrawRectangle(x + 4, y + 8, bar * scale, 8, { 0.3f, 0.8f, 0.4f, 1 });
+		test_drawer->DrawRectangle(x + 4, y + 24, bar * frame, 8, frame < 1.0f ? glm::vec4{ 0.3f, 0.6f, 1, 1 } : glm::vec4{ 1, 0.3f, 0.2f, 1 });
+
+		test_drawer->Flush();
+	};
+
+	if (scaled)
+	{
+		if (!resolution.nativeUI)
+			drawUI();
+
+		// Upscale the used part of the scene target onto the back buffer
+		context->OMSetRenderTargets(1, &backBufferView, nullptr);
+		set_rasterizer_state(lastWindowSize);
+
+		test_drawer->SetCaptureEnabled(false);
+		test_drawer->SetView(0, 0, 1, 1);
+		test_drawer->SetTexture(sceneResource);
+
+		// The quad maps the whole used region, and the samples are clamped half a
+		// texel inside it so the linear filter never reaches the cleared texels
+		glm::vec2 used = { (float)sceneSize.x / sceneTargetSize.x, (float)sceneSize.y / sceneTargetSize.y };
+		glm::vec2 halfTexel = { 0.5f / sceneTargetSize.x, 0.5f / sceneTargetSize.y };
+		set_uv_clamp({ halfTexel.x, halfTexel.y, used.x - halfTexel.x, used.y - halfTexel.y });
+
+		test_drawer->DrawTexture(0, 0, 1, 1, { 0, 0 }, used, { 1, 1, 1, 1 });
+		test_drawer->Flush();
+
+		set_uv_clamp({ 0, 0, 1, 1 });
+		test_drawer->SetTexture(nullptr);
+		test_drawer->SetCaptureEnabled(true);
+
+		// The scene target is rendered to again next frame, so it can't stay bound as an input
+		ID3D11ShaderResourceView* nullResource = nullptr;
+		context->PSSetShaderResources(0, 1, &nullResource);
+
+		if (resolution.nativeUI)
+			drawUI();
+	}
+	else
+	{
+		drawUI();
+	}
 }
 
 void Renderer_D3D11::clear_backbuffer(const glm::vec4& color, float depth, uint8_t stencil, ClearMask mask)
 {
+	Internal::capture_clear(color, depth, stencil, mask);
+
+	clearColor = color;
+
 	if (((int)mask & (int)ClearMask::Color) == (int)ClearMask::Color)
 	{
 		float clearColor[4] = { color.r, color.g, color.b, color.a };
@@ -431,6 +1476,223 @@ void Renderer_D3D11::clear_backbuffer(const glm::vec4& color, float depth, uint8
 	}
 }
 
+void Renderer_D3D11::replay(const Capture::Frame& frame)
+{
+	context->OMSetRenderTargets(1, &backBufferView, nullptr);
+	set_rasterizer_state(frame.size);
+	context->OMSetBlendState(blendState, nullptr, 0xFFFFFFFF);
+	context->IASetPrimitiveTopology(D3D11_PRIMITIVE_TOPOLOGY_TRIANGLELIST);
+	context->IASetInputLayout(inputLayout);
+
+	D3D11_RECT scissor = { 0, 0, frame.size.x, frame.size.y };
+
+	Capture::Reader reader(frame);
+	Capture::Command command;
+	const uint8* payload;
+	uint32 size;
+
+	while (reader.next(command, payload, size))
+	{
+		switch (command)
+		{
+		case Capture::Command::Clear:
+		{
+			if (size != sizeof(Capture::ClearData))
+				break;
+
+			Capture::ClearData data;
+			memcpy(&data, payload, sizeof(data));
+			clear_backbuffer(data.color, data.depth, (uint8_t)data.stencil, (ClearMask)data.mask);
+		} break;
+		case Capture::Command::Matrix:
+		{
+			if (size != sizeof(Matrix4x4))
+				break;
+
+			Matrix4x4 matrix;
+			memcpy(&matrix, payload, sizeof(matrix));
+			test_drawer->UpdateConstantBuffer(context, matrix);
+		} break;
+		case Capture::Command::Scissor:
+		{
+			if (size == sizeof(D3D11_RECT))
+				memcpy(&scissor, payload, sizeof(scissor));
+		} break;
+		case Capture::Command::Draw:
+		{
+			// Captures made with a different vertex layout can't be replayed
+			if (size % sizeof(Vertex) != 0)
+				break;
+
+			test_drawer->SubmitVertices(payload, size / sizeof(Vertex));
+			test_drawer->Submit(scissor);
+		} break;
+		case Capture::Command::Texture:
+		{
+			if (size != sizeof(Capture::TextureData))
+				break;
+
+			Capture::TextureData data;
+			memcpy(&data, payload, sizeof(data));
+
+			auto texture = data.id != 0 ? replay_texture(data) : nullptr;
+			if (texture)
+				test_drawer->SetTexture(texture->view, texture->info);
+			else
+				test_drawer->SetTexture(nullptr);
+		} break;
+		case Capture::Command::Mesh:
+		{
+			if (size < sizeof(Capture::MeshData) || (size - sizeof(Capture::MeshData)) % sizeof(Vertex) != 0)
+				break;
+
+			Capture::MeshData data;
+			memcpy(&data, payload, sizeof(data));
+
+			// Uploaded the first time this version is seen, later iterations only draw
+			auto& mesh = replayMeshes[((uint64)data.id << 32) | data.revision];
+			if (!mesh)
+			{
+				uint32 count = (size - sizeof(Capture::MeshData)) / sizeof(Vertex);
+				replayVertices.resize(count);
+				memcpy(replayVertices.data(), payload + sizeof(Capture::MeshData), sizeof(Vertex) * count);
+
+				mesh = CreateScope<Mesh_D3D11>(device, context);
+				mesh->set_vertices(replayVertices.data(), count);
+			}
+
+			test_drawer->SubmitMesh(mesh.get(), scissor);
+		} break;
+		}
+	}
+}
+
+Texture* Renderer_D3D11::create_texture(const TextureImage& image)
+{
+	if (image.mips.empty())
+		return nullptr;
+
+	// The back buffer isn't sRGB, so the encoded values are sampled as-is
+	DXGI_FORMAT format;
+	UINT blockSize;
+	switch (image.format)
+	{
+	case TextureFormat::BC1: format = DXGI_FORMAT_BC1_UNORM; blockSize = 8; break;
+	case TextureFormat::BC3: format = DXGI_FORMAT_BC3_UNORM; blockSize = 16; break;
+	default: format = DXGI_FORMAT_R8G8B8A8_UNORM; blockSize = 0; break;
+	}
+
+	// Block compressed textures need a top level that is a whole number of blocks
+	if (blockSize > 0 && (image.mips[0].width % 4 != 0 || image.mips[0].height % 4 != 0))
+	{
+		std::cerr << "Block compressed texture size must be a multiple of 4" << std::endl;
+		return nullptr;
+	}
+
+	D3D11_TEXTURE2D_DESC desc = {};
+	desc.Width = image.mips[0].width;
+	desc.Height = image.mips[0].height;
+	desc.MipLevels = (UINT)image.mips.size();
+	desc.ArraySize = 1;
+	desc.Format = format;
+	desc.SampleDesc.Count = 1;
+	desc.Usage = D3D11_USAGE_IMMUTABLE;
+	desc.BindFlags = D3D11_BIND_SHADER_RESOURCE;
+
+	std::vector<D3D11_SUBRESOURCE_DATA> data(image.mips.size());
+	uint64 bytes = 0;
+	for (size_t i = 0; i < image.mips.size(); i++)
+	{
+		auto& mip = image.mips[i];
+		data[i].pSysMem = mip.data.data();
+		data[i].SysMemPitch = blockSize > 0 ? ((mip.width + 3) / 4) * blockSize : mip.width * 4;
+		bytes += mip.data.size();
+	}
+
+	auto result = new Texture_D3D11();
+	HRESULT hr = device->CreateTexture2D(&desc, data.data(), &result->texture);
+	if (SUCCEEDED(hr))
+		hr = device->CreateShaderResourceView(result->texture, nullptr, &result->view);
+
+	if (FAILED(hr))
+	{
+		delete result;
+		return nullptr;
+	}
+
+	static uint32 next_id = 1;
+	result->info = { next_id++, image.mips[0].width, image.mips[0].height, (uint32)image.format, (uint32)image.mips.size() };
+
+	result->bytes = bytes;
+	Internal::stats_alloc(Stats::Category::Texture, bytes);
+
+	return result;
+}
+
+Texture_D3D11* Renderer_D3D11::replay_texture(const Capture::TextureData& data)
+{
+	auto found = replayTextures.find(data.id);
+	if (found != replayTextures.end())
+		return static_cast<Texture_D3D11*>(found->second.get());
+
+	// A checkerboard with the recorded size, format and mip count, so sampling
+	// costs the same as the original texture
+	Texture* texture = nullptr;
+	if (data.width > 0 && data.height > 0 && data.width <= 16384 && data.height <= 16384 && data.format <= (uint32)TextureFormat::BC3)
+	{
+		std::vector<uint8> pixels((size_t)data.width * data.height * 4);
+		for (int y = 0; y < data.height; y++)
+		{
+			for (int x = 0; x < data.width; x++)
+			{
+				uint8 value = ((x / 8 + y / 8) & 1) ? 200 : 80;
+				uint8* p = &pixels[((size_t)y * data.width + x) * 4];
+				p[0] = p[1] = p[2] = value;
+				p[3] = 255;
+			}
+		}
+
+		TextureImportOptions options;
+		options.format = (TextureFormat)data.format;
+		options.generateMips = data.mipCount > 1;
+
+		TextureImage image;
+		if (TextureImport::import_rgba(pixels.data(), data.width, data.height, options, image))
+			texture = create_texture(image);
+	}
+
+	replayTextures[data.id].reset(texture);
+	return static_cast<Texture_D3D11*>(texture);
+}
+
+Mesh* Renderer_D3D11::create_mesh()
+{
+	return new Mesh_D3D11(device, context);
+}
+
+void Renderer_D3D11::set_camera(const glm::vec2& position)
+{
+	cameraPosition = position;
+}
+
+void Renderer_D3D11::submit_particles(const ParticleSystem& particles)
+{
+	submittedParticles.push_back(&particles);
+}
+
+void Renderer_D3D11::submit_tilemap(Tilemap& tilemap)
+{
+	submittedTilemaps.push_back(&tilemap);
+}
+
+void Renderer_D3D11::set_dynamic_resolution(const DynamicResolutionSettings& settings)
+{
+	dynamicResolution.set_settings(settings);
+
+	if (!settings.enabled)
+		release_scene_target();
+}
+
 Renderer* Renderer::try_make_d3d11()
 {
 	return new Renderer_D3D11();
@@ -0,0 +1,45 @@
+#include "shapes.hpp"
+
+#include <algorithm>
+#include <unordered_map>
+
+using namespace Framework;
+
+namespace
+{
+	std::unordered_map<uint32, std::vector<glm::vec2>> shapes_circles;
+}
+
+const std::vector<glm::vec2>& Shapes::unit_circle(uint32 segments)
+{
+	segments = std::min(std::max(segments, min_segments), max_segments);
+
+	auto it = shapes_circles.find(segments);
+	if (it != shapes_circles.end())
+		return it->second;
+
+	const float step = 6.28318530718f / segments;
+
+	auto& points = shapes_circles[segments];
+	points.resize(segments);
+	for (uint32 i = 0; i < segments; i++)
+		points[i] = { cosf(step * i), sinf(step * i) };
+
+	return points;
+}
+
+uint32 Shapes::segments_for_radius(float pixelRadius)
+{
+	const float tolerance = 0.25f;
+	if (pixelRadius <= tolerance)
+		return min_segments;
+
+	// Sagitta of each segment stays under the tolerance
+	float angle = 2.0f * acosf(1.0f - tolerance / pixelRadius);
+	uint32 segments = (uint32)ceilf(6.28318530718f / angle);
+
+	// Round up to a multiple of 4 so the corners of rounded rects line up with
+	// the circle and fewer distinct tessellations end up in the cache
+	segments = (segments + 3) & ~3u;
+	return std::min(std::max(segments, min_segments), max_segments);
+}
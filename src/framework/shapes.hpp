@@ -0,0 +1,23 @@
+#pragma once
+
+#include "common.hpp"
+
+#include <vector>
+
+namespace Framework
+{
+	// Cached unit tessellations shared by all vector primitives. Shapes of the
+	// same segment count reuse one point list, scaled and offset per draw.
+	namespace Shapes
+	{
+		constexpr uint32 min_segments = 8;
+		constexpr uint32 max_segments = 256;
+
+		// Points on the unit circle, counter-clockwise from +x, without repeating the first
+		const std::vector<glm::vec2>& unit_circle(uint32 segments);
+
+		// Level of detail: segments needed to keep a circle of the given on-screen
+		// radius (in pixels) within a quarter pixel of the true curve
+		uint32 segments_for_radius(float pixelRadius);
+	}
+}
@@ -0,0 +1,144 @@
+#include "stats.hpp"
+
+#include <SDL3/SDL.h>
+
+#include <mutex>
+
+using namespace Framework;
+
+namespace
+{
+	std::mutex stats_mutex;
+	Stats::Snapshot stats_current;
+	Stats::Snapshot stats_last_frame;
+	uint64 stats_total_high_water = 0;
+
+	void check_budget(Stats::Category category, const Stats::CategoryStats& stats, uint64 previous)
+	{
+		if (stats.budget == 0)
+			return;
+
+		// Only warn when crossing the budget, not on every allocation past it
+		if (previous <= stats.budget && stats.bytes > stats.budget)
+		{
+			SDL_Log("Stats: %s over budget (%llu / %llu bytes)",
+				Stats::category_name(category),
+				(unsigned long long)stats.bytes,
+				(unsigned long long)stats.budget);
+		}
+	}
+
+	void update_totals()
+	{
+		uint64 total = 0;
+		for (auto& stats : stats_current.categories)
+			total += stats.bytes;
+
+		stats_current.totalBytes = total;
+		if (total > stats_total_high_water)
+			stats_total_high_water = total;
+		stats_current.totalHighWater = stats_total_high_water;
+	}
+}
+
+const char* Stats::category_name(Category category)
+{
+	switch (category)
+	{
+	case Category::VertexBuffer: return "VertexBuffer";
+	case Category::ConstantBuffer: return "ConstantBuffer";
+	case Category::Texture: return "Texture";
+	case Category::RenderTarget: return "RenderTarget";
+	case Category::CpuVertices: return "CpuVertices";
+	case Category::Capture: return "Capture";
+	case Category::Particles: return "Particles";
+	case Category::Tilemap: return "Tilemap";
+	case Category::Count: break;
+	}
+
+	return "Unknown";
+}
+
+void Stats::set_budget(Category category, uint64 bytes)
+{
+	std::lock_guard<std::mutex> lock(stats_mutex);
+	auto& stats = stats_current.categories[(int)category];
+	stats.budget = bytes;
+	check_budget(category, stats, 0);
+}
+
+Stats::Snapshot Stats::snapshot()
+{
+	std::lock_guard<std::mutex> lock(stats_mutex);
+	return stats_last_frame;
+}
+
+Stats::Snapshot Stats::current()
+{
+	std::lock_guard<std::mutex> lock(stats_mutex);
+	return stats_current;
+}
+
+void Internal::stats_alloc(Stats::Category category, uint64 bytes)
+{
+	std::lock_guard<std::mutex> lock(stats_mutex);
+	auto& stats = stats_current.categories[(int)category];
+	auto previous = stats.bytes;
+
+	stats.bytes += bytes;
+	stats.allocations++;
+	stats.frameAllocations++;
+	if (stats.bytes > stats.highWater)
+		stats.highWater = stats.bytes;
+
+	check_budget(category, stats, previous);
+	update_totals();
+}
+
+void Internal::stats_release(Stats::Category category, uint64 bytes)
+{
+	std::lock_guard<std::mutex> lock(stats_mutex);
+	auto& stats = stats_current.categories[(int)category];
+
+	stats.bytes = bytes > stats.bytes ? 0 : stats.bytes - bytes;
+	stats.releases++;
+
+	update_totals();
+}
+
+void Internal::stats_resize(Stats::Category category, uint64 oldBytes, uint64 newBytes)
+{
+	if (oldBytes == newBytes)
+		return;
+
+	// One step, so the budget check sees the bytes from before the resize
+	std::lock_guard<std::mutex> lock(stats_mutex);
+	auto& stats = stats_current.categories[(int)category];
+	auto previous = stats.bytes;
+
+	stats.bytes = oldBytes > stats.bytes ? 0 : stats.bytes - oldBytes;
+	if (oldBytes > 0)
+		stats.releases++;
+
+	if (newBytes > 0)
+	{
+		stats.bytes += newBytes;
+		stats.allocations++;
+		stats.frameAllocations++;
+		if (stats.bytes > stats.highWater)
+			stats.highWater = stats.bytes;
+	}
+
+	check_budget(category, stats, previous);
+	update_totals();
+}
+
+void Internal::stats_frame_end()
+{
+	std::lock_guard<std::mutex> lock(stats_mutex);
+	stats_last_frame = stats_current;
+
+	stats_current.frame++;
+	for (auto& stats : stats_current.categories)
+		stats.frameAllocations = 0;
+}
@@ -0,0 +1,60 @@
+#pragma once
+
+#include "common.hpp"
+
+namespace Framework
+{
+	// Per-category accounting of GPU resources and large CPU-side allocations
+	namespace Stats
+	{
+		enum class Category : uint8
+		{
+			VertexBuffer,
+			ConstantBuffer,
+			Texture,
+			RenderTarget,
+			CpuVertices,
+			Capture,
+			Particles,
+			Tilemap,
+			Count
+		};
+
+		struct CategoryStats
+		{
+			uint64 bytes = 0;
+			uint64 highWater = 0;
+			uint64 budget = 0;				// 0 = unlimited
+			uint32 allocations = 0;
+			uint32 releases = 0;
+			uint32 frameAllocations = 0;	// allocations made during the frame
+		};
+
+		struct Snapshot
+		{
+			uint64 frame = 0;
+			uint64 totalBytes = 0;
+			uint64 totalHighWater = 0;
+			CategoryStats categories[(int)Category::Count];
+		};
+
+		const char* category_name(Category category);
+
+		// Logs a warning whenever the category grows past the budget
+		void set_budget(Category category, uint64 bytes);
+
+		// Stats as of the last completed frame
+		Snapshot snapshot();
+
+		// Stats including the frame in progress
+		Snapshot current();
+	}
+
+	namespace Internal
+	{
+		void stats_alloc(Stats::Category category, uint64 bytes);
+		void stats_release(Stats::Category category, uint64 bytes);
+		void stats_resize(Stats::Category category, uint64 oldBytes, uint64 newBytes);
+		void stats_frame_end();
+	}
+}
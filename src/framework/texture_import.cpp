@@ -0,0 +1,907 @@
+#include "texture_import.hpp"
+#include "jobs.hpp"
+
+#include <SDL3/SDL.h>
+#include <stb_image.h>
+
+#include <algorithm>
+#include <stdio.h>
+#include <stdlib.h>
+#include <string.h>
+#include <string>
+
+#if defined(__SSE2__) || defined(_M_X64) || defined(_M_AMD64)
+#include <xmmintrin.h>
+#define TEXTURE_IMPORT_SSE 1
+#endif
+
+using namespace Framework;
+
+namespace
+{
+	constexpr uint32 cache_magic = 0x58544744; // "DGTX"
+	constexpr uint32 cache_version = 2;
+
+	struct CacheHeader
+	{
+		uint32 magic;
+		uint32 version;
+		uint32 format;
+		uint32 srgb;
+		uint32 mipCount;
+	};
+
+	struct CacheMipHeader
+	{
+		int32 width;
+		int32 height;
+		uint32 byteSize;
+	};
+
+	uint64 hash_bytes(const void* data, size_t size, uint64 hash = 14695981039346656037ull)
+	{
+		auto bytes = (const uint8*)data;
+		for (size_t i = 0; i < size; i++)
+		{
+			hash ^= bytes[i];
+			hash *= 1099511628211ull;
+		}
+		return hash;
+	}
+
+	int block_count(int size)
+	{
+		return (size + 3) / 4;
+	}
+
+	int block_bytes(TextureFormat format)
+	{
+		return format == TextureFormat::BC1 ? 8 : 16;
+	}
+
+	size_t mip_bytes(TextureFormat format, int width, int height)
+	{
+		if (format == TextureFormat::RGBA8)
+			return (size_t)width * height * 4;
+
+		return (size_t)block_count(width) * block_count(height) * block_bytes(format);
+	}
+
+	// ------------------------------------------------------------------
+	// Linear float images, 4 floats per pixel
+	// ------------------------------------------------------------------
+
+	struct FloatImage
+	{
+		int width = 0;
+		int height = 0;
+		std::vector<float> pixels;
+
+		float* at(int x, int y) { return &pixels[((size_t)y * width + x) * 4]; }
+		const float* at(int x, int y) const { return &pixels[((size_t)y * width + x) * 4]; }
+	};
+
+	float srgb_to_linear(float c)
+	{
+		return c <= 0.04045f ? c / 12.92f : powf((c + 0.055f) / 1.055f, 2.4f);
+	}
+
+	float linear_to_srgb(float c)
+	{
+		return c <= 0.0031308f ? c * 12.92f : 1.055f * powf(c, 1.0f / 2.4f) - 0.055f;
+	}
+
+	uint8 to_unorm8(float c)
+	{
+		c = c < 0.0f ? 0.0f : (c > 1.0f ? 1.0f : c);
+		return (uint8)(c * 255.0f + 0.5f);
+	}
+
+	void to_float(const uint8* pixels, int width, int height, bool srgb, FloatImage& image)
+	{
+		float table[256];
+		for (int i = 0; i < 256; i++)
+			table[i] = srgb ? srgb_to_linear(i / 255.0f) : i / 255.0f;
+
+		image.width = width;
+		image.height = height;
+		image.pixels.resize((size_t)width * height * 4);
+
+		size_t count = (size_t)width * height;
+		for (size_t i = 0; i < count; i++)
+		{
+			image.pixels[i * 4 + 0] = table[pixels[i * 4 + 0]];
+			image.pixels[i * 4 + 1] = table[pixels[i * 4 + 1]];
+			image.pixels[i * 4 + 2] = table[pixels[i * 4 + 2]];
+			image.pixels[i * 4 + 3] = pixels[i * 4 + 3] / 255.0f;
+		}
+	}
+
+	void to_rgba8(const FloatImage& image, bool srgb, TextureMip& mip)
+	{
+		mip.width = image.width;
+		mip.height = image.height;
+		mip.data.resize((size_t)image.width * image.height * 4);
+
+		Jobs::parallel_for(image.height, [&](int y)
+		{
+			for (int x = 0; x < image.width; x++)
+			{
+				const float* src = image.at(x, y);
+				uint8* dst = &mip.data[((size_t)y * image.width + x) * 4];
+
+				for (int c = 0; c < 3; c++)
+					dst[c] = to_unorm8(srgb ? linear_to_srgb(src[c]) : src[c]);
+				dst[3] = to_unorm8(src[3]);
+			}
+		});
+	}
+
+	// 4-wide helpers so the filters read the same with or without SSE
+#if TEXTURE_IMPORT_SSE
+	using Pixel = __m128;
+	inline Pixel pixel_load(const float* p) { return _mm_loadu_ps(p); }
+	inline void pixel_store(float* p, Pixel v) { _mm_storeu_ps(p, v); }
+	inline Pixel pixel_zero() { return _mm_setzero_ps(); }
+	inline Pixel pixel_add(Pixel a, Pixel b) { return _mm_add_ps(a, b); }
+	inline Pixel pixel_scale(Pixel a, float s) { return _mm_mul_ps(a, _mm_set1_ps(s)); }
+#else
+	struct Pixel { float v[4]; };
+	inline Pixel pixel_load(const float* p) { return { { p[0], p[1], p[2], p[3] } }; }
+	inline void pixel_store(float* p, Pixel v) { memcpy(p, v.v, sizeof(v.v)); }
+	inline Pixel pixel_zero() { return { { 0, 0, 0, 0 } }; }
+	inline Pixel pixel_add(Pixel a, Pixel b) { return { { a.v[0] + b.v[0], a.v[1] + b.v[1], a.v[2] + b.v[2], a.v[3] + b.v[3] } }; }
+	inline Pixel pixel_scale(Pixel a, float s) { return { { a.v[0] * s, a.v[1] * s, a.v[2] * s, a.v[3] * s } }; }
+#endif
+
+	// Source taps of one output pixel along an axis. Even sizes average 2 pixels,
+	// odd sizes spread 3 pixels over the output so the last one still contributes.
+	struct BoxTaps
+	{
+		int index[3];
+		float weight[3];
+	};
+
+	BoxTaps box_taps(int x, int srcSize, int dstSize)
+	{
+		if (srcSize == 1)
+			return { { 0, 0, 0 }, { 1.0f, 0.0f, 0.0f } };
+
+		if (srcSize % 2 == 0)
+			return { { x * 2, x * 2 + 1, x * 2 + 1 }, { 0.5f, 0.5f, 0.0f } };
+
+		float size = (float)srcSize;
+		return { { x * 2, x * 2 + 1, x * 2 + 2 }, { (dstSize - x) / size, dstSize / size, (x + 1) / size } };
+	}
+
+	void downsample_box(const FloatImage& src, FloatImage& dst)
+	{
+		std::vector<BoxTaps> columns(dst.width);
+		for (int x = 0; x < dst.width; x++)
+			columns[x] = box_taps(x, src.width, dst.width);
+
+		Jobs::parallel_for(dst.height, [&](int y)
+		{
+			BoxTaps row = box_taps(y, src.height, dst.height);
+
+			for (int x = 0; x < dst.width; x++)
+			{
+				const BoxTaps& column = columns[x];
+
+				Pixel sum = pixel_zero();
+				for (int j = 0; j < 3; j++)
+				{
+					if (row.weight[j] == 0.0f)
+						continue;
+
+					for (int i = 0; i < 3; i++)
+					{
+						if (column.weight[i] == 0.0f)
+							continue;
+
+						sum = pixel_add(sum, pixel_scale(pixel_load(src.at(column.index[i], row.index[j])), row.weight[j] * column.weight[i]));
+					}
+				}
+				pixel_store(dst.at(x, y), sum);
+			}
+		});
+	}
+
+	// Kaiser-windowed sinc, 6 taps per axis for a 2:1 reduction
+	constexpr int kaiser_taps = 6;
+
+	float bessel_i0(float x)
+	{
+		float sum = 1.0f, term = 1.0f;
+		for (int k = 1; k < 16; k++)
+		{
+			term *= (x / (2.0f * k)) * (x / (2.0f * k));
+			sum += term;
+		}
+		return sum;
+	}
+
+	void kaiser_weights(float weights[kaiser_taps])
+	{
+		const float pi = 3.14159265358979f;
+		const float alpha = 4.0f;
+		const float radius = 3.0f;
+
+		float total = 0.0f;
+		for (int i = 0; i < kaiser_taps; i++)
+		{
+			// Distance from the output pixel center, in source pixels
+			float d = (float)i - 2.5f;
+			float t = d / 2.0f;
+			float sinc = sinf(pi * t) / (pi * t);
+			float r = d / radius;
+			float window = bessel_i0(alpha * sqrtf(std::max(0.0f, 1.0f - r * r))) / bessel_i0(alpha);
+
+			weights[i] = sinc * window;
+			total += weights[i];
+		}
+
+		for (int i = 0; i < kaiser_taps; i++)
+			weights[i] /= total;
+	}
+
+	void downsample_kaiser(const FloatImage& src, FloatImage& dst)
+	{
+		float weights[kaiser_taps];
+		kaiser_weights(weights);
+
+		// Horizontal pass into an intermediate of (dst.width, src.height)
+		FloatImage tmp;
+		tmp.width = dst.width;
+		tmp.height = src.height;
+		tmp.pixels.resize((size_t)tmp.width * tmp.height * 4);
+
+		Jobs::parallel_for(src.height, [&](int y)
+		{
+			for (int x = 0; x < dst.width; x++)
+			{
+				Pixel sum = pixel_zero();
+				for (int i = 0; i < kaiser_taps; i++)
+				{
+					int sx = std::min(std::max(x * 2 - 2 + i, 0), src.width - 1);
+					sum = pixel_add(sum, pixel_scale(pixel_load(src.at(sx, y)), weights[i]));
+				}
+				pixel_store(tmp.at(x, y), sum);
+			}
+		});
+
+		// Vertical pass
+		Jobs::parallel_for(dst.height, [&](int y)
+		{
+			for (int x = 0; x < dst.width; x++)
+			{
+				Pixel sum = pixel_zero();
+				for (int i = 0; i < kaiser_taps; i++)
+				{
+					int sy = std::min(std::max(y * 2 - 2 + i, 0), tmp.height - 1);
+					sum = pixel_add(sum, pixel_scale(pixel_load(tmp.at(x, sy)), weights[i]));
+				}
+				pixel_store(dst.at(x, y), sum);
+			}
+		});
+	}
+
+	// ------------------------------------------------------------------
+	// Block compression
+	// ------------------------------------------------------------------
+
+	void fetch_block(const TextureMip& rgba, int bx, int by, uint8 block[64])
+	{
+		for (int y = 0; y < 4; y++)
+		{
+			int sy = std::min(by * 4 + y, rgba.height - 1);
+			for (int x = 0; x < 4; x++)
+			{
+				int sx = std::min(bx * 4 + x, rgba.width - 1);
+				memcpy(&block[(y * 4 + x) * 4], &rgba.data[((size_t)sy * rgba.width + sx) * 4], 4);
+			}
+		}
+	}
+
+	uint16 pack_565(const float c[3])
+	{
+		int r = std::min(std::max((int)(c[0] * 31.0f / 255.0f + 0.5f), 0), 31);
+		int g = std::min(std::max((int)(c[1] * 63.0f / 255.0f + 0.5f), 0), 63);
+		int b = std::min(std::max((int)(c[2] * 31.0f / 255.0f + 0.5f), 0), 31);
+		return (uint16)((r << 11) | (g << 5) | b);
+	}
+
+	void unpack_565(uint16 c, int out[3])
+	{
+		int r = (c >> 11) & 31, g = (c >> 5) & 63, b = c & 31;
+		out[0] = (r << 3) | (r >> 2);
+		out[1] = (g << 2) | (g >> 4);
+		out[2] = (b << 3) | (b >> 2);
+	}
+
+	void write_le(uint8* out, uint64 value, int bytes)
+	{
+		for (int i = 0; i < bytes; i++)
+			out[i] = (uint8)(value >> (i * 8));
+	}
+
+	uint64 read_le(const uint8* in, int bytes)
+	{
+		uint64 value = 0;
+		for (int i = 0; i < bytes; i++)
+			value |= (uint64)in[i] << (i * 8);
+		return value;
+	}
+
+	// Endpoints are the extremes along the principal axis of the block's colors
+	void encode_color_block(const uint8 block[64], uint8 out[8])
+	{
+		float mean[3] = { 0, 0, 0 };
+		for (int i = 0; i < 16; i++)
+			for (int c = 0; c < 3; c++)
+				mean[c] += block[i * 4 + c] / 16.0f;
+
+		float cov[6] = { 0, 0, 0, 0, 0, 0 };
+		for (int i = 0; i < 16; i++)
+		{
+			float r = block[i * 4 + 0] - mean[0];
+			float g = block[i * 4 + 1] - mean[1];
+			float b = block[i * 4 + 2] - mean[2];
+			cov[0] += r * r; cov[1] += r * g; cov[2] += r * b;
+			cov[3] += g * g; cov[4] += g * b; cov[5] += b * b;
+		}
+
+		// A few power iterations are enough for a 3x3 matrix
+		float axis[3] = { 1.0f, 1.0f, 1.0f };
+		for (int n = 0; n < 4; n++)
+		{
+			float x = cov[0] * axis[0] + cov[1] * axis[1] + cov[2] * axis[2];
+			float y = cov[1] * axis[0] + cov[3] * axis[1] + cov[4] * axis[2];
+			float z = cov[2] * axis[0] + cov[4] * axis[1] + cov[5] * axis[2];
+			float length = std::max(std::max(fabsf(x), fabsf(y)), fabsf(z));
+			if (length <= 0.0f)
+				break;
+			axis[0] = x / length; axis[1] = y / length; axis[2] = z / length;
+		}
+
+		float minDot = 1e30f, maxDot = -1e30f;
+		int minIndex = 0, maxIndex = 0;
+		for (int i = 0; i < 16; i++)
+		{
+			float d = block[i * 4 + 0] * axis[0] + block[i * 4 + 1] * axis[1] + block[i * 4 + 2] * axis[2];
+			if (d < minDot) { minDot = d; minIndex = i; }
+			if (d > maxDot) { maxDot = d; maxIndex = i; }
+		}
+
+		float hi[3], lo[3];
+		for (int c = 0; c < 3; c++)
+		{
+			hi[c] = block[maxIndex * 4 + c];
+			lo[c] = block[minIndex * 4 + c];
+		}
+
+		uint16 c0 = pack_565(hi);
+		uint16 c1 = pack_565(lo);
+		if (c0 < c1)
+			std::swap(c0, c1);
+
+		uint32 indices = 0;
+		if (c0 != c1)
+		{
+			int palette[4][3];
+			unpack_565(c0, palette[0]);
+			unpack_565(c1, palette[1]);
+			for (int c = 0; c < 3; c++)
+			{
+				palette[2][c] = (2 * palette[0][c] + palette[1][c]) / 3;
+				palette[3][c] = (palette[0][c] + 2 * palette[1][c]) / 3;
+			}
+
+			for (int i = 0; i < 16; i++)
+			{
+				int best = 0, bestError = INT32_MAX;
+				for (int p = 0; p < 4; p++)
+				{
+					int dr = block[i * 4 + 0] - palette[p][0];
+					int dg = block[i * 4 + 1] - palette[p][1];
+					int db = block[i * 4 + 2] - palette[p][2];
+					int error = dr * dr + dg * dg + db * db;
+					if (error < bestError) { bestError = error; best = p; }
+				}
+				indices |= (uint32)best << (i * 2);
+			}
+		}
+
+		write_le(out + 0, c0, 2);
+		write_le(out + 2, c1, 2);
+		write_le(out + 4, indices, 4);
+	}
+
+	void encode_alpha_block(const uint8 block[64], uint8 out[8])
+	{
+		int a0 = 0, a1 = 255;
+		for (int i = 0; i < 16; i++)
+		{
+			a0 = std::max(a0, (int)block[i * 4 + 3]);
+			a1 = std::min(a1, (int)block[i * 4 + 3]);
+		}
+
+		uint64 indices = 0;
+		if (a0 != a1)
+		{
+			// a0 > a1 selects the 8-value mode
+			int palette[8] = { a0, a1 };
+			for (int i = 1; i < 7; i++)
+				palette[i + 1] = ((7 - i) * a0 + i * a1) / 7;
+
+			for (int i = 0; i < 16; i++)
+			{
+				int best = 0, bestError = INT32_MAX;
+				for (int p = 0; p < 8; p++)
+				{
+					int error = abs(block[i * 4 + 3] - palette[p]);
+					if (error < bestError) { bestError = error; best = p; }
+				}
+				indices |= (uint64)best << (i * 3);
+			}
+		}
+
+		out[0] = (uint8)a0;
+		out[1] = (uint8)a1;
+		write_le(out + 2, indices, 6);
+	}
+
+	void decode_color_block(const uint8 in[8], bool allowTransparent, uint8 block[64])
+	{
+		uint16 c0 = (uint16)read_le(in + 0, 2);
+		uint16 c1 = (uint16)read_le(in + 2, 2);
+		uint32 indices = (uint32)read_le(in + 4, 4);
+
+		int palette[4][4];
+		unpack_565(c0, palette[0]);
+		unpack_565(c1, palette[1]);
+		palette[0][3] = palette[1][3] = palette[2][3] = palette[3][3] = 255;
+
+		if (c0 > c1 || !allowTransparent)
+		{
+			for (int c = 0; c < 3; c++)
+			{
+				palette[2][c] = (2 * palette[0][c] + palette[1][c]) / 3;
+				palette[3][c] = (palette[0][c] + 2 * palette[1][c]) / 3;
+			}
+		}
+		else
+		{
+			for (int c = 0; c < 3; c++)
+			{
+				palette[2][c] = (palette[0][c] + palette[1][c]) / 2;
+				palette[3][c] = 0;
+			}
+			palette[3][3] = 0;
+		}
+
+		for (int i = 0; i < 16; i++)
+		{
+			int index = (indices >> (i * 2)) & 3;
+			for (int c = 0; c < 4; c++)
+				block[i * 4 + c] = (uint8)palette[index][c];
+		}
+	}
+
+	void decode_alpha_block(const uint8 in[8], uint8 block[64])
+	{
+		int a0 = in[0], a1 = in[1];
+		uint64 indices = read_le(in + 2, 6);
+
+		int palette[8] = { a0, a1 };
+		if (a0 > a1)
+		{
+			for (int i = 1; i < 7; i++)
+				palette[i + 1] = ((7 - i) * a0 + i * a1) / 7;
+		}
+		else
+		{
+			for (int i = 1; i < 5; i++)
+				palette[i + 1] = ((5 - i) * a0 + i * a1) / 5;
+			palette[6] = 0;
+			palette[7] = 255;
+		}
+
+		for (int i = 0; i < 16; i++)
+			block[i * 4 + 3] = (uint8)palette[(indices >> (i * 3)) & 7];
+	}
+}
+
+bool TextureImport::import_file(const char* path, const TextureImportOptions& options, TextureImage& image, const char* cacheDir)
+{
+	FILE* file = fopen(path, "rb");
+	if (!file)
+	{
+		SDL_Log("TextureImport: failed to open %s", path);
+		return false;
+	}
+
+	std::vector<uint8> source;
+	fseek(file, 0, SEEK_END);
+	long fileSize = ftell(file);
+	fseek(file, 0, SEEK_SET);
+
+	if (fileSize <= 0)
+	{
+		SDL_Log("TextureImport: failed to read %s", path);
+		fclose(file);
+		return false;
+	}
+
+	source.resize((size_t)fileSize);
+	size_t read = fread(source.data(), 1, source.size(), file);
+	fclose(file);
+
+	if (read != source.size())
+		return false;
+
+	std::string cachePath;
+	if (cacheDir)
+	{
+		uint32 key[5] = { cache_version, (uint32)options.format, (uint32)options.filter, options.srgb, options.generateMips };
+		uint64 hash = hash_bytes(source.data(), source.size());
+		hash = hash_bytes(key, sizeof(key), hash);
+
+		char name[32];
+		snprintf(name, sizeof(name), "%016llx.d3dtex", (unsigned long long)hash);
+		cachePath = std::string(cacheDir) + "/" + name;
+
+		if (load_cache(cachePath.c_str(), image))
+			return true;
+	}
+
+	int width, height, channels;
+	uint8* pixels = stbi_load_from_memory(source.data(), (int)source.size(), &width, &height, &channels, 4);
+	if (!pixels)
+	{
+		SDL_Log("TextureImport: failed to decode %s: %s", path, stbi_failure_reason());
+		return false;
+	}
+
+	bool result = import_rgba(pixels, width, height, options, image);
+	stbi_image_free(pixels);
+
+	if (result && cacheDir)
+		save_cache(cachePath.c_str(), image);
+
+	return result;
+}
+
+bool TextureImport::import_rgba(const uint8* pixels, int width, int height, const TextureImportOptions& options, TextureImage& image)
+{
+	if (!pixels || width <= 0 || height <= 0)
+		return false;
+
+	image.format = options.format;
+	image.srgb = options.srgb;
+	image.mips.clear();
+
+	// D3D11 needs the top level of a block compressed texture to be whole blocks.
+	// Padding would shift the UVs, so unaligned images stay uncompressed.
+	if (image.format != TextureFormat::RGBA8 && (width % 4 != 0 || height % 4 != 0))
+		image.format = TextureFormat::RGBA8;
+
+	std::vector<TextureMip> levels;
+	if (options.generateMips)
+	{
+		build_mips(pixels, width, height, options.filter, options.srgb, levels);
+	}
+	else
+	{
+		levels.resize(1);
+		levels[0].width = width;
+		levels[0].height = height;
+		levels[0].data.assign(pixels, pixels + (size_t)width * height * 4);
+	}
+
+	if (image.format == TextureFormat::RGBA8)
+	{
+		image.mips = std::move(levels);
+		return true;
+	}
+
+	image.mips.resize(levels.size());
+	for (size_t i = 0; i < levels.size(); i++)
+		compress(levels[i], image.format, image.mips[i]);
+
+	return true;
+}
+
+void TextureImport::build_mips(const uint8* pixels, int width, int height, MipFilter filter, bool srgb, std::vector<TextureMip>& mips)
+{
+	mips.clear();
+	mips.emplace_back();
+	mips[0].width = width;
+	mips[0].height = height;
+	mips[0].data.assign(pixels, pixels + (size_t)width * height * 4);
+
+	// Each level is filtered from the previous one at full float precision
+	FloatImage current;
+	to_float(pixels, width, height, srgb, current);
+
+	while (current.width > 1 || current.height > 1)
+	{
+		FloatImage next;
+		next.width = std::max(1, current.width / 2);
+		next.height = std::max(1, current.height / 2);
+		next.pixels.resize((size_t)next.width * next.height * 4);
+
+		if (filter == MipFilter::Kaiser)
+			downsample_kaiser(current, next);
+		else
+			downsample_box(current, next);
+
+		mips.emplace_back();
+		to_rgba8(next, srgb, mips.back());
+
+		current = std::move(next);
+	}
+}
+
+void TextureImport::compress(const TextureMip& rgba, TextureFormat format, TextureMip& compressed)
+{
+	compressed.width = rgba.width;
+	compressed.height = rgba.height;
+
+	if (format == TextureFormat::RGBA8)
+	{
+		compressed.data = rgba.data;
+		return;
+	}
+
+	int blocksX = block_count(rgba.width);
+	int blocksY = block_count(rgba.height);
+	int stride = block_bytes(format);
+	compressed.data.resize((size_t)blocksX * blocksY * stride);
+
+	Jobs::parallel_for(blocksY, [&](int by)
+	{
+		uint8 block[64];
+		for (int bx = 0; bx < blocksX; bx++)
+		{
+			uint8* out = &compressed.data[((size_t)by * blocksX + bx) * stride];
+			fetch_block(rgba, bx, by, block);
+
+			if (format == TextureFormat::BC3)
+			{
+				encode_alpha_block(block, out);
+				encode_color_block(block, out + 8);
+			}
+			else
+			{
+				encode_color_block(block, out);
+			}
+		}
+	});
+}
+
+void TextureImport::decompress(const TextureMip& compressed, TextureFormat format, TextureMip& rgba)
+{
+	rgba.width = compressed.width;
+	rgba.height = compressed.height;
+
+	if (format == TextureFormat::RGBA8)
+	{
+		rgba.data = compressed.data;
+		return;
+	}
+
+	rgba.data.resize((size_t)compressed.width * compressed.height * 4);
+
+	int blocksX = block_count(compressed.width);
+	int blocksY = block_count(compressed.height);
+	int stride = block_bytes(format);
+
+	Jobs::parallel_for(blocksY, [&](int by)
+	{
+		uint8 block[64];
+		for (int bx = 0; bx < blocksX; bx++)
+		{
+			const uint8* in = &compressed.data[((size_t)by * blocksX + bx) * stride];
+
+			if (format == TextureFormat::BC3)
+			{
+				decode_color_block(in + 8, false, block);
+				decode_alpha_block(in, block);
+			}
+			else
+			{
+				decode_color_block(in, true, block);
+			}
+
+			// Drop the padding of blocks that hang over the edge
+			for (int y = 0; y < 4 && by * 4 + y < rgba.height; y++)
+			{
+				for (int x = 0; x < 4 && bx * 4 + x < rgba.width; x++)
+				{
+					size_t offset = ((size_t)(by * 4 + y) * rgba.width + (bx * 4 + x)) * 4;
+					memcpy(&rgba.data[offset], &block[(y * 4 + x) * 4], 4);
+				}
+			}
+		}
+	});
+}
+
+float TextureImport::psnr(const TextureMip& a, const TextureMip& b)
+{
+	if (a.width != b.width || a.height != b.height || a.data.size() != b.data.size() || a.data.empty())
+		return 0.0f;
+
+	double error = 0.0;
+	for (size_t i = 0; i < a.data.size(); i++)
+	{
+		double d = (double)a.data[i] - (double)b.data[i];
+		error += d * d;
+	}
+
+	double mse = error / (double)a.data.size();
+	if (mse <= 0.0)
+		return INFINITY;
+
+	return (float)(10.0 * log10(255.0 * 255.0 / mse));
+}
+
+bool TextureImport::save_cache(const char* path, const TextureImage& image)
+{
+	FILE* file = fopen(path, "wb");
+	if (!file)
+	{
+		SDL_Log("TextureImport: failed to write cache %s", path);
+		return false;
+	}
+
+	CacheHeader header = { cache_magic, cache_version, (uint32)image.format, image.srgb ? 1u : 0u, (uint32)image.mips.size() };
+	fwrite(&header, sizeof(header), 1, file);
+
+	for (auto& mip : image.mips)
+	{
+		CacheMipHeader mipHeader = { mip.width, mip.height, (uint32)mip.data.size() };
+		fwrite(&mipHeader, sizeof(mipHeader), 1, file);
+		fwrite(mip.data.data(), 1, mip.data.size(), file);
+	}
+
+	fclose(file);
+	return true;
+}
+
+bool TextureImport::load_cache(const char* path, TextureImage& image)
+{
+	FILE* file = fopen(path, "rb");
+	if (!file)
+		return false;
+
+	fseek(file, 0, SEEK_END);
+	long fileSize = ftell(file);
+	fseek(file, 0, SEEK_SET);
+
+	// A mip chain never has more than 32 levels
+	CacheHeader header;
+	if (fileSize < 0 || fread(&header, sizeof(header), 1, file) != 1 || header.magic != cache_magic || header.version != cache_version ||
+		header.format > (uint32)TextureFormat::BC3 || header.mipCount == 0 || header.mipCount > 32)
+	{
+		fclose(file);
+		return false;
+	}
+
+	image.format = (TextureFormat)header.format;
+	image.srgb = header.srgb != 0;
+	image.mips.resize(header.mipCount);
+
+	// The entry is handed straight to the GPU, so every level has to be exactly
+	// the size its dimensions imply, and fit in what is left of the file
+	uint64 remaining = (uint64)fileSize - sizeof(header);
+	for (size_t i = 0; i < image.mips.size(); i++)
+	{
+		auto& mip = image.mips[i];
+
+		CacheMipHeader mipHeader;
+		if (fread(&mipHeader, sizeof(mipHeader), 1, file) != 1)
+		{
+			fclose(file);
+			return false;
+		}
+		remaining -= std::min<uint64>(remaining, sizeof(mipHeader));
+
+		bool valid = mipHeader.width > 0 && mipHeader.height > 0 && mipHeader.width <= 16384 && mipHeader.height <= 16384;
+		if (valid && i == 0 && image.format != TextureFormat::RGBA8)
+			valid = mipHeader.width % 4 == 0 && mipHeader.height % 4 == 0;
+		if (valid && i > 0)
+			valid = mipHeader.width == std::max(1, image.mips[i - 1].width / 2) && mipHeader.height == std::max(1, image.mips[i - 1].height / 2);
+		if (valid)
+			valid = mipHeader.byteSize == mip_bytes(image.format, mipHeader.width, mipHeader.height) && mipHeader.byteSize <= remaining;
+
+		if (!valid)
+		{
+			SDL_Log("TextureImport: cache %s is corrupt", path);
+			fclose(file);
+			return false;
+		}
+		remaining -= mipHeader.byteSize;
+
+		mip.width = mipHeader.width;
+		mip.height = mipHeader.height;
+		mip.data.resize(mipHeader.byteSize);
+		if (fread(mip.data.data(), 1, mip.data.size(), file) != mip.data.size())
+		{
+			fclose(file);
+			return false;
+		}
+	}
+
+	fclose(file);
+	return true;
+}
+
+bool TextureImport::run_quality_check(const char* path)
+{
+	TextureImportOptions options;
+	options.format = TextureFormat::RGBA8;
+
+	TextureImage source;
+	if (path)
+	{
+		if (!import_file(path, options, source))
+			return false;
+	}
+	else
+	{
+		// Gradients with a hard-edged pattern, sized so every level is unaligned
+		const int width = 157, height = 93;
+		std::vector<uint8> pixels((size_t)width * height * 4);
+		for (int y = 0; y < height; y++)
+		{
+			for (int x = 0; x < width; x++)
+			{
+				uint8* p = &pixels[((size_t)y * width + x) * 4];
+				p[0] = (uint8)(x * 255 / width);
+				p[1] = (uint8)(y * 255 / height);
+				p[2] = ((x / 8 + y / 8) & 1) ? 200 : 40;
+				p[3] = (uint8)((x + y) * 255 / (width + height));
+			}
+		}
+
+		if (!import_rgba(pixels.data(), width, height, options, source))
+			return false;
+	}
+
+	SDL_Log("TextureImport: %s, %dx%d, %zu levels", path ? path : "generated image",
+		source.mips[0].width, source.mips[0].height, source.mips.size());
+
+	const double frequency = (double)SDL_GetPerformanceFrequency();
+	for (auto format : { TextureFormat::BC1, TextureFormat::BC3 })
+	{
+		const char* name = format == TextureFormat::BC1 ? "BC1" : "BC3";
+
+		std::vector<TextureMip> compressed(source.mips.size());
+		uint64 start = SDL_GetPerformanceCounter();
+		for (size_t i = 0; i < source.mips.size(); i++)
+			compress(source.mips[i], format, compressed[i]);
+		double ms = (double)(SDL_GetPerformanceCounter() - start) * 1000.0 / frequency;
+
+		SDL_Log("%s: %zu levels compressed in %.2f ms", name, compressed.size(), ms);
+
+		for (size_t i = 0; i < compressed.size(); i++)
+		{
+			TextureMip decoded;
+			decompress(compressed[i], format, decoded);
+
+			// BC1 is decoded opaque here, so compare against an opaque reference
+			TextureMip reference = source.mips[i];
+			if (format == TextureFormat::BC1)
+			{
+				for (size_t a = 3; a < reference.data.size(); a += 4)
+					reference.data[a] = 255;
+			}
+
+			SDL_Log("  level %zu (%dx%d): %.2f dB, %zu bytes", i, reference.width, reference.height,
+				psnr(reference, decoded), compressed[i].data.size());
+		}
+	}
+
+	return true;
+}
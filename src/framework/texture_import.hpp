@@ -0,0 +1,60 @@
+#pragma once
+
+#include "common.hpp"
+#include "graphics.hpp"
+
+#include <vector>
+
+namespace Framework
+{
+	struct TextureMip
+	{
+		int width = 0;
+		int height = 0;
+		std::vector<uint8> data;
+	};
+
+	struct TextureImage
+	{
+		TextureFormat format = TextureFormat::RGBA8;
+		bool srgb = true;
+		std::vector<TextureMip> mips;
+	};
+
+	struct TextureImportOptions
+	{
+		TextureFormat format = TextureFormat::BC3;	// RGBA8 when the size isn't a multiple of 4
+		MipFilter filter = MipFilter::Box;
+		bool srgb = true;			// filter mips in linear space
+		bool generateMips = true;
+	};
+
+	// Offline import stage: decodes with stb_image, builds the mip chain and
+	// block-compresses every level across all cores.
+	namespace TextureImport
+	{
+		// When cacheDir is set the result is read from / written to a cache file
+		// keyed on the source bytes and the options
+		bool import_file(const char* path, const TextureImportOptions& options, TextureImage& image, const char* cacheDir = nullptr);
+
+		bool import_rgba(const uint8* pixels, int width, int height, const TextureImportOptions& options, TextureImage& image);
+
+		// Mip chain in RGBA8, level 0 is a copy of the source
+		void build_mips(const uint8* pixels, int width, int height, MipFilter filter, bool srgb, std::vector<TextureMip>& mips);
+
+		void compress(const TextureMip& rgba, TextureFormat format, TextureMip& compressed);
+
+		// CPU decoder so compression quality can be checked without a GPU
+		void decompress(const TextureMip& compressed, TextureFormat format, TextureMip& rgba);
+
+		// Peak signal-to-noise ratio in dB between two RGBA8 images of the same size
+		float psnr(const TextureMip& a, const TextureMip& b);
+
+		bool save_cache(const char* path, const TextureImage& image);
+		bool load_cache(const char* path, TextureImage& image);
+
+		// Headless BC1/BC3 round trip of every mip level, logs the PSNR of each.
+		// Without a path a generated odd-sized image is used.
+		bool run_quality_check(const char* path);
+	}
+}
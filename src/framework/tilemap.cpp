@@ -0,0 +1,173 @@
+#include "tilemap.hpp"
+#include "renderer.hpp"
+#include "stats.hpp"
+
+#include <algorithm>
+
+using namespace Framework;
+
+Tilemap::Tilemap(Renderer* renderer, int width, int height, float tileSize, int chunkSize)
+	: renderer(renderer), width(width), height(height), chunkSize(chunkSize), tileSize(tileSize)
+{
+	chunksX = (width + chunkSize - 1) / chunkSize;
+	chunksY = (height + chunkSize - 1) / chunkSize;
+
+	tiles.resize((size_t)width * height, empty_tile);
+	chunks.resize((size_t)chunksX * chunksY);
+	Internal::stats_alloc(Stats::Category::Tilemap, tiles.size() * sizeof(uint16));
+
+	for (int cy = 0; cy < chunksY; cy++)
+	{
+		for (int cx = 0; cx < chunksX; cx++)
+		{
+			auto& chunk = chunks[(size_t)cy * chunksX + cx];
+			chunk.x = cx;
+			chunk.y = cy;
+		}
+	}
+}
+
+Tilemap::~Tilemap()
+{
+	for (auto& chunk : chunks)
+		delete chunk.mesh;
+
+	Internal::stats_release(Stats::Category::Tilemap, tiles.size() * sizeof(uint16) + trackedScratchCapacity * sizeof(Vertex));
+}
+
+void Tilemap::set_tile(int x, int y, uint16 tile)
+{
+	if (x < 0 || y < 0 || x >= width || y >= height)
+		return;
+
+	auto& current = tiles[(size_t)y * width + x];
+	if (current == tile)
+		return;
+
+	current = tile;
+	chunks[(size_t)(y / chunkSize) * chunksX + (x / chunkSize)].dirty = true;
+}
+
+uint16 Tilemap::get_tile(int x, int y) const
+{
+	if (x < 0 || y < 0 || x >= width || y >= height)
+		return empty_tile;
+
+	return tiles[(size_t)y * width + x];
+}
+
+void Tilemap::set_tileset(const Texture* texture, int columns, int rows)
+{
+	tileset = texture;
+	tilesetColumns = std::max(columns, 1);
+	tilesetRows = std::max(rows, 1);
+	mark_all_dirty();
+}
+
+void Tilemap::set_position(const glm::vec2& value)
+{
+	position = value;
+	mark_all_dirty();
+}
+
+void Tilemap::set_tint(const glm::vec4& value)
+{
+	tint = value;
+	mark_all_dirty();
+}
+
+void Tilemap::mark_all_dirty()
+{
+	for (auto& chunk : chunks)
+		chunk.dirty = true;
+}
+
+void Tilemap::visible_chunks(const glm::vec2& viewMin, const glm::vec2& viewMax, std::vector<const Chunk*>& out)
+{
+	out.clear();
+
+	const float chunkExtent = chunkSize * tileSize;
+	int x0 = std::max((int)floorf((viewMin.x - position.x) / chunkExtent), 0);
+	int y0 = std::max((int)floorf((viewMin.y - position.y) / chunkExtent), 0);
+	int x1 = std::min((int)floorf((viewMax.x - position.x) / chunkExtent), chunksX - 1);
+	int y1 = std::min((int)floorf((viewMax.y - position.y) / chunkExtent), chunksY - 1);
+
+	for (int cy = y0; cy <= y1; cy++)
+	{
+		for (int cx = x0; cx <= x1; cx++)
+		{
+			auto& chunk = chunks[(size_t)cy * chunksX + cx];
+			if (chunk.dirty)
+				build_chunk(cx, cy);
+
+			if (chunk.mesh && chunk.mesh->vertex_count() > 0)
+				out.push_back(&chunk);
+		}
+	}
+}
+
+void Tilemap::build_chunk(int cx, int cy)
+{
+	auto& chunk = chunks[(size_t)cy * chunksX + cx];
+	chunk.dirty = false;
+
+	chunk_vertices(chunk, scratch);
+
+	// The scratch only grows to the largest chunk, so this is where its footprint changes
+	if (scratch.capacity() != trackedScratchCapacity)
+	{
+		Internal::stats_resize(Stats::Category::Tilemap, trackedScratchCapacity * sizeof(Vertex), scratch.capacity() * sizeof(Vertex));
+		trackedScratchCapacity = scratch.capacity();
+	}
+
+	if (!chunk.mesh && !scratch.empty())
+		chunk.mesh = renderer->create_mesh();
+
+	if (chunk.mesh)
+		chunk.mesh->set_vertices(scratch.data(), (uint32)scratch.size());
+}
+
+void Tilemap::chunk_vertices(const Chunk& chunk, std::vector<Vertex>& out) const
+{
+	out.clear();
+
+	const glm::vec2 tileUV = { 1.0f / tilesetColumns, 1.0f / tilesetRows };
+	const glm::vec4 mask = tileset ? VertexMask::Textured : VertexMask::Solid;
+
+	// Half a texel in from the cell edges, so linear filtering stays inside the tile
+	glm::vec2 inset = { 0, 0 };
+	if (tileset)
+	{
+		glm::ivec2 size = tileset->get_size();
+		inset = { 0.5f / std::max(size.x, 1), 0.5f / std::max(size.y, 1) };
+	}
+
+	int tx0 = chunk.x * chunkSize, tx1 = std::min(tx0 + chunkSize, width);
+	int ty0 = chunk.y * chunkSize, ty1 = std::min(ty0 + chunkSize, height);
+
+	for (int y = ty0; y < ty1; y++)
+	{
+		for (int x = tx0; x < tx1; x++)
+		{
+			uint16 tile = tiles[(size_t)y * width + x];
+			if (tile == empty_tile)
+				continue;
+
+			glm::vec2 p0 = { position.x + x * tileSize, position.y + y * tileSize };
+			glm::vec2 p1 = { p0.x + tileSize, p0.y + tileSize };
+			glm::vec2 cell = { (tile % tilesetColumns) * tileUV.x, (tile / tilesetColumns % tilesetRows) * tileUV.y };
+			glm::vec2 uv0 = cell + inset;
+			glm::vec2 uv1 = cell + tileUV - inset;
+
+			Vertex quad[6] = {
+				{ p0, uv0, tint, mask },
+				{ { p1.x, p0.y }, { uv1.x, uv0.y }, tint, mask },
+				{ { p0.x, p1.y }, { uv0.x, uv1.y }, tint, mask },
+				{ { p1.x, p0.y }, { uv1.x, uv0.y }, tint, mask },
+				{ p1, uv1, tint, mask },
+				{ { p0.x, p1.y }, { uv0.x, uv1.y }, tint, mask },
+			};
+			out.insert(out.end(), std::begin(quad), std::end(quad));
+		}
+	}
+}
@@ -0,0 +1,77 @@
+#pragma once
+
+#include "common.hpp"
+#include "graphics.hpp"
+
+#include <vector>
+
+class Renderer;
+
+namespace Framework
+{
+	// Tile layer split into fixed-size chunks. Each chunk's geometry lives in a
+	// retained mesh that is rebuilt only after one of its tiles changes, and only
+	// once the chunk is actually in view.
+	class Tilemap
+	{
+	public:
+		static constexpr uint16 empty_tile = 0xFFFF;
+
+		struct Chunk
+		{
+			Mesh* mesh = nullptr;
+			int x = 0;
+			int y = 0;
+			bool dirty = true;
+		};
+
+		Tilemap(Renderer* renderer, int width, int height, float tileSize, int chunkSize = 32);
+		~Tilemap();
+
+		Tilemap(const Tilemap&) = delete;
+		Tilemap& operator=(const Tilemap&) = delete;
+
+		void set_tile(int x, int y, uint16 tile);
+
+		uint16 get_tile(int x, int y) const;
+
+		// Tile atlas and its layout, tiles index it row by row. Without a texture
+		// tiles draw as flat tint quads.
+		void set_tileset(const Texture* texture, int columns, int rows);
+
+		const Texture* get_tileset() const { return tileset; }
+
+		// Both are baked into the chunk geometry, so changing them rebuilds every chunk
+		void set_position(const glm::vec2& position);
+		void set_tint(const glm::vec4& tint);
+
+		// Chunks overlapping the world-space view rect, rebuilding dirty ones first
+		void visible_chunks(const glm::vec2& viewMin, const glm::vec2& viewMax, std::vector<const Chunk*>& out);
+
+		// Regenerates a chunk's geometry on the CPU, the mesh only keeps it on the GPU
+		void chunk_vertices(const Chunk& chunk, std::vector<Vertex>& out) const;
+
+	private:
+		Renderer* renderer;
+		int width;
+		int height;
+		int chunkSize;
+		int chunksX;
+		int chunksY;
+		float tileSize;
+		const Texture* tileset = nullptr;
+		int tilesetColumns = 1;
+		int tilesetRows = 1;
+
+		glm::vec2 position = { 0, 0 };
+		glm::vec4 tint = { 1, 1, 1, 1 };
+
+		std::vector<uint16> tiles;
+		std::vector<Chunk> chunks;
+		std::vector<Vertex> scratch;
+		size_t trackedScratchCapacity = 0;
+
+		void mark_all_dirty();
+		void build_chunk(int cx, int cy);
+	};
+}
@@ -1,11 +1,46 @@
 #include "framework/app.hpp"
+#include "framework/particles.hpp"
+#include "framework/texture_import.hpp"
+
+#include <stdlib.h>
+#include <string.h>
 
 using namespace Framework;
 
 int main(int argc, char* argv[])
 {
+    // Headless replay: game --replay <file> [iterations]
+    if (argc >= 3 && strcmp(argv[1], "--replay") == 0)
+    {
+        uint32 iterations = 100;
+        if (argc >= 4)
+            iterations = (uint32)atoi(argv[3]);
+
+        bool success = App::replay(argv[2], iterations > 0 ? iterations : 1, RendererType::D3D11);
+        App::exit();
+
+        return success ? 0 : 1;
+    }
+
+    // Headless particle benchmark: game --bench-particles [count] [frames]
+    if (argc >= 2 && strcmp(argv[1], "--bench-particles") == 0)
+    {
+        uint32 count = argc >= 3 ? (uint32)atoi(argv[2]) : 250000;
+        uint32 frames = argc >= 4 ? (uint32)atoi(argv[3]) : 600;
+        Particles::run_benchmark(count > 0 ? count : 1, frames > 0 ? frames : 1);
+
+        return 0;
+    }
+
+    // Headless texture compression check: game --texture-check [file]
+    if (argc >= 2 && strcmp(argv[1], "--texture-check") == 0)
+    {
+        bool success = TextureImport::run_quality_check(argc >= 3 ? argv[2] : nullptr);
+        return success ? 0 : 1;
+    }
+
     App::run();
     App::exit();
 
 	return 0;
-}
\ No newline at end of file
+}
@@ -14,15 +14,19 @@ struct vs_out
 	float4 mask : MASK;
 };
 
+cbuffer sampling : register(b1)
+{
+	float4 u_uv_clamp; // min.xy, max.xy
+};
+
+Texture2D u_texture : register(t0);
+SamplerState u_texture_sampler : register(s0);
+
 float4 ps_main(vs_out input) : SV_TARGET
 {
-    /*
-	float4 color = u_texture.Sample(u_texture_sampler, input.texcoord);
+	float4 color = u_texture.Sample(u_texture_sampler, clamp(input.texcoord, u_uv_clamp.xy, u_uv_clamp.zw));
 	return
 		input.mask.x * color * input.color + 
 		input.mask.y * color.a * input.color + 
 		input.mask.z * input.color;
-        */
-
-    return input.color; // Output the vertex color
 }
\ No newline at end of file